@@ -0,0 +1,58 @@
+/*
+ * FILE: bench.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header file declares the benchmark driver (histo-bench) for the IPC and counting hot paths:
+ * ring operations single and bulk, lock-free and semaphore-guarded, copy and zero-copy, records,
+ * 1->N producer scaling, the counting kernels and the renderer. Each benchmark prints one JSON line.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "../../common/inc/shared_memory.h"
+#include "../../common/inc/latency_histogram.h"
+#include <stdint.h>
+
+// Defaults, changed with -t and -p
+#define BENCH_DEFAULT_SECONDS 0.5   // Time spent in each benchmark
+#define BENCH_DEFAULT_PRODUCERS 4   // Largest producer count in the scaling benchmark
+#define BENCH_RING_CAPACITY (64UL * 1024)  // Lane capacity used by every ring benchmark
+#define BENCH_BULK 64               // Letters per bulk operation
+#define BENCH_COUNT_BATCH 4096      // Letters per counting call, DC's drain batch
+#define BENCH_KERNEL_BATCH (64 * 1024)  // Letters per kernel call
+
+// One benchmark: runs a chunk of work and returns how many operations it did
+typedef uint64_t (*bench_chunk_t)(void *context);
+
+// Ring set up outside SysV shared memory, so benchmarks never touch a running system's segment
+typedef struct {
+    shared_memory_t *shm;
+    size_t size;
+    int semid;
+} bench_ring_t;
+
+// Ring helpers
+int bench_ring_create(bench_ring_t *ring, int lane_count, int ring_mode, int ring_format);
+void bench_ring_destroy(bench_ring_t *ring);
+
+// Driver
+uint64_t now_ns(void);
+void run_benchmark(const char *name, int items_per_op, bench_chunk_t chunk, void *context);
+void report(const char *name, int items_per_op, uint64_t ops, uint64_t elapsed_ns, const latency_histogram_t *per_op);
+int selected(const char *name);
+
+// Benchmark groups
+void bench_ring_ops(void);
+void bench_records(void);
+void bench_producer_scaling(void);
+void bench_counting(void);
+void bench_rendering(void);
+
+// Global variables
+extern double bench_seconds;     // Time per benchmark (-t)
+extern int bench_max_producers;  // Producer counts 1, 2, 4 ... up to this (-p)
+extern const char *bench_filter; // Only run benchmarks whose name contains this (-f)
+
+#endif /* BENCH_H */
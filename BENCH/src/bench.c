@@ -0,0 +1,695 @@
+/*
+ * FILE: bench.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This file implements histo-bench, the microbenchmarks for the ring (circular_buffer.c) and for
+ * the counting and rendering work DC does. Every benchmark runs its work in chunks for a fixed
+ * time; the time of each chunk divided by its operations goes into a latency histogram, so besides
+ * the overall ops/s and ns/op each result carries p50/p99/p99.9 of the per-chunk ns/op.
+ * Results are printed as one JSON object per line on stdout, ready to be diffed or loaded by a
+ * script; progress goes to stderr. Rings live in anonymous shared mappings rather than the SysV
+ * segment, so the producer scaling benchmark can fork producers without touching a running system,
+ * and semaphore mode uses a private semaphore.
+ */
+#define _DEFAULT_SOURCE  // Enables MAP_ANONYMOUS and clock_gettime
+
+#include "../inc/bench.h"
+#include "../../common/inc/circular_buffer.h"
+#include "../../common/inc/histogram_kernel.h"
+#include "../../common/inc/histogram_render.h"
+#include "../../common/inc/sliding_window.h"
+#include "../../common/inc/semaphore_utils.h"
+#include "../../common/inc/common.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define CHUNK_TARGET_NS 20000ULL  // Chunks are sized to take about this long, for fine-grained percentiles
+
+// Global variables
+volatile symbol_t bench_sink;  // Written by the benchmark consumers so their reads are not optimized away
+double bench_seconds = BENCH_DEFAULT_SECONDS;
+int bench_max_producers = BENCH_DEFAULT_PRODUCERS;
+const char *bench_filter = NULL;
+
+/*
+ * Name    : now_ns
+ * Purpose : Monotonic clock in nanoseconds
+ * Input   : None
+ * Outputs : None
+ * Returns : Current CLOCK_MONOTONIC time
+ */
+uint64_t now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * Name    : selected
+ * Purpose : Check a benchmark name against the -f filter
+ * Input   : Benchmark name
+ * Outputs : None
+ * Returns : 1 if the benchmark should run
+ */
+int selected(const char *name) {
+    return bench_filter == NULL || strstr(name, bench_filter) != NULL;
+}
+
+/*
+ * Name    : bench_ring_create
+ * Purpose : Build a ring exactly as DP-1 would, but in an anonymous shared mapping
+ * Input   : Ring, lane count, RING_MODE_*, RING_FORMAT_*
+ * Outputs : Ring mapped and initialized (with a private semaphore in semaphore mode)
+ * Returns : 0 on success, -1 on failure
+ */
+int bench_ring_create(bench_ring_t *ring, int lane_count, int ring_mode, int ring_format) {
+    shared_memory_t *shm;
+    union semun argument;
+
+    ring->size = shm_segment_size(BENCH_RING_CAPACITY, lane_count);
+    shm = mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shm == MAP_FAILED) {
+        perror("histo-bench: mmap");
+        return -1;
+    }
+    shm->header.magic = SHM_MAGIC;
+    shm->header.version = SHM_LAYOUT_VERSION;
+    shm->header.capacity = BENCH_RING_CAPACITY;
+    shm->header.mask = BENCH_RING_CAPACITY - 1;
+    shm->header.lane_count = (uint32_t)lane_count;
+    shm->header.symbol_bins = LETTER_RANGE;
+    shm->header.data_offset = offsetof(shared_memory_t, buffer);
+    shm->header.segment_size = ring->size;
+    init_shared_memory(shm, ring_mode, ring_format);
+    ring->shm = shm;
+
+    ring->semid = -1;
+    if (ring_mode == RING_MODE_SEMAPHORE) {
+        ring->semid = semget(IPC_PRIVATE, 1, IPC_CREAT | 0600);
+        argument.val = 1;
+        if (ring->semid == -1 || semctl(ring->semid, 0, SETVAL, argument) == -1) {
+            perror("histo-bench: semget");
+            bench_ring_destroy(ring);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Name    : bench_ring_destroy
+ * Purpose : Unmap a benchmark ring and remove its semaphore
+ * Input   : Ring
+ * Outputs : Ring released
+ * Returns : None
+ */
+void bench_ring_destroy(bench_ring_t *ring) {
+    if (ring->semid != -1) {
+        remove_semaphore(ring->semid);
+    }
+    munmap(ring->shm, ring->size);
+    ring->shm = NULL;
+}
+
+/*
+ * Name    : report
+ * Purpose : Print one benchmark result as a JSON line
+ * Input   : Name, items (letters) per operation, operations, elapsed time, per-op latency in picoseconds
+ * Outputs : JSON line on stdout
+ * Returns : None
+ */
+void report(const char *name, int items_per_op, uint64_t ops, uint64_t elapsed_ns, const latency_histogram_t *per_op) {
+    double seconds = elapsed_ns / 1e9;
+    double ops_per_s = (seconds > 0) ? ops / seconds : 0.0;
+
+    printf("{\"bench\":\"%s\",\"items_per_op\":%d,\"ops\":%llu,\"seconds\":%.3f,\"ops_per_s\":%.1f,"
+           "\"ns_per_op\":%.3f,\"items_per_s\":%.1f,\"p50_ns\":%.3f,\"p99_ns\":%.3f,\"p999_ns\":%.3f}\n",
+           name, items_per_op, (unsigned long long)ops, seconds, ops_per_s,
+           (ops > 0) ? (double)elapsed_ns / ops : 0.0, ops_per_s * items_per_op,
+           latency_percentile(per_op, 50.0) / 1000.0, latency_percentile(per_op, 99.0) / 1000.0,
+           latency_percentile(per_op, 99.9) / 1000.0);
+    fflush(stdout);
+}
+
+/*
+ * Name    : run_benchmark
+ * Purpose : Run a chunk function repeatedly for bench_seconds and report the result
+ * Input   : Name, items per operation, chunk function, its context
+ * Outputs : Result printed (nothing happens if the name does not match the filter)
+ * Returns : None
+ */
+void run_benchmark(const char *name, int items_per_op, bench_chunk_t chunk, void *context) {
+    static latency_histogram_t per_op;  // Picoseconds per operation, one sample per chunk
+    uint64_t limit = (uint64_t)(bench_seconds * 1e9);
+    uint64_t ops = 0;
+    uint64_t start;
+    uint64_t elapsed = 0;
+
+    if (!selected(name)) {
+        return;
+    }
+    fprintf(stderr, "histo-bench: %s\n", name);
+    latency_reset(&per_op);
+
+    // One untimed chunk warms the caches and lets lazy setup (kernel dispatch, page faults) happen
+    (void)chunk(context);
+
+    start = now_ns();
+    while (elapsed < limit) {
+        uint64_t chunk_start = now_ns();
+        uint64_t done = chunk(context);
+        uint64_t chunk_end = now_ns();
+
+        if (done > 0) {
+            latency_record(&per_op, (chunk_end - chunk_start) * 1000ULL / done);
+            ops += done;
+        }
+        elapsed = chunk_end - start;
+    }
+    report(name, items_per_op, ops, elapsed, &per_op);
+}
+
+/* ---- Ring operations ---- */
+
+// Context of the single-threaded ring benchmarks: write then read back on lane 0
+typedef struct {
+    bench_ring_t ring;
+    int repeat;        // Operations per chunk
+    symbol_t letters[BENCH_BULK];
+    int next_lane;
+    uint64_t consumed;
+} ring_context_t;
+
+/*
+ * Name    : fill_letters
+ * Purpose : Cheap in-place fill for the zero-copy benchmark, so the ring cost is what is measured
+ * Input   : Slots, number of slots
+ * Outputs : Slots filled
+ * Returns : None
+ */
+static void fill_letters(symbol_t *letters, int count) {
+    memset(letters, MIN_LETTER, (size_t)count * sizeof(symbol_t));
+}
+
+/*
+ * Name    : consume_letters
+ * Purpose : Cheap in-place consumer for the zero-copy benchmark
+ * Input   : Letters, number of letters
+ * Outputs : None
+ * Returns : None
+ */
+static void consume_letters(const symbol_t *letters, int count) {
+    if (count > 0) {
+        bench_sink = letters[count - 1];  // Touch the data like a real consumer
+    }
+}
+
+/*
+ * Name    : consume_words
+ * Purpose : Cheap in-place consumer for the packed benchmark
+ * Input   : Packed words, number of words
+ * Outputs : None
+ * Returns : None
+ */
+static void consume_words(const uint64_t *words, int count) {
+    if (count > 0) {
+        bench_sink = (symbol_t)words[count - 1];  // Touch the data like a real consumer
+    }
+}
+
+/*
+ * Name    : chunk_single
+ * Purpose : write_to_buffer then read_from_buffer, one letter, guarded like DC and DP-1 guard them
+ * Input   : ring_context_t
+ * Outputs : None
+ * Returns : Operations done
+ */
+static uint64_t chunk_single(void *context) {
+    ring_context_t *c = context;
+    shared_memory_t *shm = c->ring.shm;
+    symbol_t letter;
+
+    for (int i = 0; i < c->repeat; i++) {
+        ring_lock(shm, c->ring.semid);
+        write_to_buffer(shm, 0, c->letters[0]);
+        ring_unlock(shm, c->ring.semid);
+        ring_lock(shm, c->ring.semid);
+        read_from_buffer(shm, 0, &letter);
+        ring_unlock(shm, c->ring.semid);
+    }
+    return (uint64_t)c->repeat;
+}
+
+/*
+ * Name    : chunk_bulk
+ * Purpose : bulk_write_to_buffer then bulk_read_from_buffer, BENCH_BULK letters, guarded
+ * Input   : ring_context_t
+ * Outputs : None
+ * Returns : Operations done
+ */
+static uint64_t chunk_bulk(void *context) {
+    ring_context_t *c = context;
+    shared_memory_t *shm = c->ring.shm;
+    symbol_t out[BENCH_BULK];
+
+    for (int i = 0; i < c->repeat; i++) {
+        ring_lock(shm, c->ring.semid);
+        bulk_write_to_buffer(shm, 0, c->letters, BENCH_BULK);
+        ring_unlock(shm, c->ring.semid);
+        ring_lock(shm, c->ring.semid);
+        bulk_read_from_buffer(shm, 0, out, BENCH_BULK);
+        ring_unlock(shm, c->ring.semid);
+    }
+    return (uint64_t)c->repeat;
+}
+
+/*
+ * Name    : chunk_copy_path
+ * Purpose : The copying producer and consumer paths: write_with_policy then bulk_read_from_lanes
+ * Input   : ring_context_t
+ * Outputs : None
+ * Returns : Operations done
+ */
+static uint64_t chunk_copy_path(void *context) {
+    ring_context_t *c = context;
+    symbol_t out[BENCH_BULK];
+
+    for (int i = 0; i < c->repeat; i++) {
+        fill_letters(c->letters, BENCH_BULK);
+        write_with_policy(c->ring.shm, c->ring.semid, 0, c->letters, BENCH_BULK);
+        ring_lock(c->ring.shm, c->ring.semid);
+        bulk_read_from_lanes(c->ring.shm, &c->next_lane, out, BENCH_BULK);
+        ring_unlock(c->ring.shm, c->ring.semid);
+        consume_letters(out, BENCH_BULK);
+    }
+    return (uint64_t)c->repeat;
+}
+
+/*
+ * Name    : chunk_zero_copy_path
+ * Purpose : The zero-copy paths: write_in_place then consume_from_lanes
+ * Input   : ring_context_t
+ * Outputs : None
+ * Returns : Operations done
+ */
+static uint64_t chunk_zero_copy_path(void *context) {
+    ring_context_t *c = context;
+
+    for (int i = 0; i < c->repeat; i++) {
+        write_in_place(c->ring.shm, c->ring.semid, 0, fill_letters, BENCH_BULK);
+        ring_lock(c->ring.shm, c->ring.semid);
+        consume_from_lanes(c->ring.shm, &c->next_lane, BENCH_BULK, consume_letters);
+        ring_unlock(c->ring.shm, c->ring.semid);
+    }
+    return (uint64_t)c->repeat;
+}
+
+/*
+ * Name    : chunk_packed_path
+ * Purpose : The packed paths: write_in_place (which packs) then consume_packed_from_lanes
+ * Input   : ring_context_t
+ * Outputs : None
+ * Returns : Operations done
+ */
+static uint64_t chunk_packed_path(void *context) {
+    ring_context_t *c = context;
+
+    for (int i = 0; i < c->repeat; i++) {
+        write_in_place(c->ring.shm, c->ring.semid, 0, fill_letters, BENCH_BULK);
+        ring_lock(c->ring.shm, c->ring.semid);
+        consume_packed_from_lanes(c->ring.shm, &c->next_lane, PACKED_WORDS(BENCH_BULK), consume_words);
+        ring_unlock(c->ring.shm, c->ring.semid);
+    }
+    return (uint64_t)c->repeat;
+}
+
+/*
+ * Name    : bench_ring_ops
+ * Purpose : Single vs bulk, lock-free vs semaphore, copy vs zero-copy vs packed ring operations
+ * Input   : None
+ * Outputs : Results printed
+ * Returns : None
+ */
+void bench_ring_ops(void) {
+    static const struct {
+        const char *name;
+        int ring_mode;
+        int ring_format;
+        int items;
+        bench_chunk_t chunk;
+    } cases[] = {
+        { "ring_single_lockfree", RING_MODE_LOCKFREE, RING_FORMAT_SYMBOLS, 1, chunk_single },
+        { "ring_single_semaphore", RING_MODE_SEMAPHORE, RING_FORMAT_SYMBOLS, 1, chunk_single },
+        { "ring_bulk64_lockfree", RING_MODE_LOCKFREE, RING_FORMAT_SYMBOLS, BENCH_BULK, chunk_bulk },
+        { "ring_bulk64_semaphore", RING_MODE_SEMAPHORE, RING_FORMAT_SYMBOLS, BENCH_BULK, chunk_bulk },
+        { "ring_copy64_lockfree", RING_MODE_LOCKFREE, RING_FORMAT_SYMBOLS, BENCH_BULK, chunk_copy_path },
+        { "ring_zerocopy64_lockfree", RING_MODE_LOCKFREE, RING_FORMAT_SYMBOLS, BENCH_BULK, chunk_zero_copy_path },
+        { "ring_packed64_lockfree", RING_MODE_LOCKFREE, RING_FORMAT_PACKED, BENCH_BULK, chunk_packed_path },
+    };
+    static ring_context_t context;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        // The packed format only exists in the A-T build
+        if (cases[i].ring_format == RING_FORMAT_PACKED && !PACKED_RING_SUPPORTED) {
+            continue;
+        }
+        if (!selected(cases[i].name) || bench_ring_create(&context.ring, 1, cases[i].ring_mode,
+                                                          cases[i].ring_format) == -1) {
+            continue;
+        }
+        fill_letters(context.letters, BENCH_BULK);
+        context.next_lane = 0;
+        // Semaphore operations are syscalls, so fewer of them fill a chunk
+        context.repeat = (cases[i].ring_mode == RING_MODE_SEMAPHORE) ? 16 : 256;
+        run_benchmark(cases[i].name, cases[i].items, cases[i].chunk, &context);
+        bench_ring_destroy(&context.ring);
+    }
+}
+
+/* ---- Records ---- */
+
+// Context of the record benchmark
+typedef struct {
+    bench_ring_t ring;
+    record_t records[BENCH_BULK];
+    record_batch_t batch;
+    int next_lane;
+} record_context_t;
+
+/*
+ * Name    : chunk_records
+ * Purpose : write_records then read_records_from_lanes, BENCH_BULK records with 8-byte payloads
+ * Input   : record_context_t
+ * Outputs : None
+ * Returns : Operations done
+ */
+static uint64_t chunk_records(void *context) {
+    record_context_t *c = context;
+
+    for (int i = 0; i < 16; i++) {
+        write_records(c->ring.shm, c->ring.semid, 0, c->records, BENCH_BULK);
+        read_records_from_lanes(c->ring.shm, &c->next_lane, &c->batch, BENCH_BULK);
+    }
+    return 16;
+}
+
+/*
+ * Name    : bench_records
+ * Purpose : Framed record enqueue and batched dequeue
+ * Input   : None
+ * Outputs : Result printed
+ * Returns : None
+ */
+void bench_records(void) {
+    static record_context_t context;
+    static const uint64_t payload = 0x5A5A5A5A5A5A5A5AULL;
+
+    if (!selected("records64_lockfree") ||
+        bench_ring_create(&context.ring, 1, RING_MODE_LOCKFREE, RING_FORMAT_RECORDS) == -1) {
+        return;
+    }
+    for (int i = 0; i < BENCH_BULK; i++) {
+        context.records[i].key = (uint32_t)(i % LETTER_RANGE);
+        context.records[i].timestamp_ns = (uint64_t)i;
+        context.records[i].payload = &payload;
+        context.records[i].payload_length = sizeof(payload);
+    }
+    run_benchmark("records64_lockfree", BENCH_BULK, chunk_records, &context);
+    bench_ring_destroy(&context.ring);
+}
+
+/* ---- Producer scaling ---- */
+
+// Context of the scaling benchmark: the consumer side, in this process
+typedef struct {
+    bench_ring_t ring;
+    int next_lane;
+} scaling_context_t;
+
+/*
+ * Name    : chunk_drain
+ * Purpose : One DC-style drain pass over every lane (consume_from_lanes)
+ * Input   : scaling_context_t
+ * Outputs : None
+ * Returns : Letters consumed
+ */
+static uint64_t chunk_drain(void *context) {
+    scaling_context_t *c = context;
+
+    return (uint64_t)consume_from_lanes(c->ring.shm, &c->next_lane, BENCH_COUNT_BATCH, consume_letters);
+}
+
+/*
+ * Name    : run_producer
+ * Purpose : Child process body: write BENCH_BULK letters at a time to one lane until killed
+ * Input   : Ring, lane
+ * Outputs : Letters written
+ * Returns : Never
+ */
+static void run_producer(bench_ring_t *ring, int lane) {
+    symbol_t letters[BENCH_BULK];
+
+    fill_letters(letters, BENCH_BULK);
+    for (;;) {
+        write_with_policy(ring->shm, ring->semid, lane, letters, BENCH_BULK);
+    }
+}
+
+/*
+ * Name    : bench_producer_scaling
+ * Purpose : 1 -> N producer processes, each on its own lane, drained by one consumer
+ * Input   : None
+ * Outputs : Results printed (items_per_s is the consumer's letter throughput)
+ * Returns : None
+ */
+void bench_producer_scaling(void) {
+    static scaling_context_t context;
+    char name[64];
+
+    for (int producers = 1; producers <= bench_max_producers && producers <= MAX_PRODUCERS; producers *= 2) {
+        pid_t pids[MAX_PRODUCERS];
+
+        snprintf(name, sizeof(name), "producers_%d_lockfree", producers);
+        if (!selected(name) || bench_ring_create(&context.ring, producers, RING_MODE_LOCKFREE,
+                                                 RING_FORMAT_SYMBOLS) == -1) {
+            continue;
+        }
+        context.next_lane = 0;
+
+        fflush(stdout);
+        for (int i = 0; i < producers; i++) {
+            pids[i] = fork();
+            if (pids[i] == 0) {
+                run_producer(&context.ring, i);
+            }
+        }
+        run_benchmark(name, 1, chunk_drain, &context);
+        for (int i = 0; i < producers; i++) {
+            if (pids[i] > 0) {
+                kill(pids[i], SIGKILL);
+                waitpid(pids[i], NULL, 0);
+            }
+        }
+        bench_ring_destroy(&context.ring);
+    }
+}
+
+/* ---- Counting and rendering ---- */
+
+// Context of the counting benchmarks
+typedef struct {
+    symbol_t *letters;
+    int count;
+    uint64_t counts[LETTER_RANGE];
+    window_set_t windows;
+} count_context_t;
+
+/*
+ * Name    : chunk_kernel
+ * Purpose : count_letters over one large batch with the selected kernel
+ * Input   : count_context_t
+ * Outputs : None
+ * Returns : Letters counted
+ */
+static uint64_t chunk_kernel(void *context) {
+    count_context_t *c = context;
+
+    count_letters(c->letters, (size_t)c->count, c->counts);
+    return (uint64_t)c->count;
+}
+
+/*
+ * Name    : chunk_dc_update
+ * Purpose : What DC does per drained batch: count a BENCH_COUNT_BATCH batch and add it to the windows
+ * Input   : count_context_t
+ * Outputs : None
+ * Returns : Letters counted
+ */
+static uint64_t chunk_dc_update(void *context) {
+    count_context_t *c = context;
+    uint64_t batch_counts[LETTER_RANGE] = {0};
+
+    count_letters(c->letters, BENCH_COUNT_BATCH, batch_counts);
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        c->counts[i] += batch_counts[i];
+    }
+    windows_add(&c->windows, batch_counts);
+    return BENCH_COUNT_BATCH;
+}
+
+/*
+ * Name    : chunk_generate
+ * Purpose : The producers' letter generator over one large batch
+ * Input   : count_context_t
+ * Outputs : None
+ * Returns : Letters generated
+ */
+static uint64_t chunk_generate(void *context) {
+    count_context_t *c = context;
+
+    generate_random_letters(c->letters, c->count);
+    return (uint64_t)c->count;
+}
+
+/*
+ * Name    : bench_counting
+ * Purpose : Every counting kernel this CPU supports, DC's per-batch update, and the generator
+ * Input   : None
+ * Outputs : Results printed (ops are letters)
+ * Returns : None
+ */
+void bench_counting(void) {
+    static count_context_t context;
+    static const char *const kernels[] = { "scalar", "sse2", "avx2" };
+    char name[64];
+
+    context.count = BENCH_KERNEL_BATCH;
+    context.letters = malloc((size_t)context.count * sizeof(symbol_t));
+    if (context.letters == NULL) {
+        perror("histo-bench: malloc");
+        return;
+    }
+    init_random(1);
+    generate_random_letters(context.letters, context.count);
+    windows_init(&context.windows);
+
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        if (select_count_kernel(kernels[i]) == -1) {
+            continue;  // Not built for this domain or not supported by this CPU
+        }
+        snprintf(name, sizeof(name), "count_%s", kernels[i]);
+        run_benchmark(name, 1, chunk_kernel, &context);
+    }
+    select_count_kernel(NULL);
+    run_benchmark("dc_update4096", 1, chunk_dc_update, &context);
+    run_benchmark("generate_letters", 1, chunk_generate, &context);
+    free(context.letters);
+}
+
+// Context of the rendering benchmarks
+typedef struct {
+    histogram_renderer_t renderer;
+    uint64_t counts[LETTER_RANGE];
+} render_context_t;
+
+/*
+ * Name    : chunk_render
+ * Purpose : One histogram frame, with one count changing per frame as during a run
+ * Input   : render_context_t
+ * Outputs : Frame written to /dev/null
+ * Returns : Frames rendered
+ */
+static uint64_t chunk_render(void *context) {
+    render_context_t *c = context;
+
+    c->counts[c->counts[0] % LETTER_RANGE] += 7;
+    c->counts[0]++;
+    render_histogram(&c->renderer, c->counts);
+    return 1;
+}
+
+/*
+ * Name    : bench_rendering
+ * Purpose : Full frames (output not a terminal) and diff frames (terminal) in every bar mode
+ * Input   : None
+ * Outputs : Results printed (ops are frames)
+ * Returns : None
+ */
+void bench_rendering(void) {
+    static render_context_t context;
+    static const char *const modes[] = { "classic", "log", "auto" };
+    char name[64];
+    int fd = open("/dev/null", O_WRONLY);
+
+    if (fd == -1) {
+        perror("histo-bench: /dev/null");
+        return;
+    }
+    for (int diff = 0; diff <= 1; diff++) {
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            if (renderer_init(&context.renderer, fd, parse_bar_mode(modes[m]), RENDER_DEFAULT_WIDTH) == -1) {
+                continue;
+            }
+            // Pretend /dev/null is a terminal to measure the diff renderer
+            context.renderer.use_cursor = diff;
+            for (int i = 0; i < LETTER_RANGE; i++) {
+                context.counts[i] = 100 + (uint64_t)i * 13;
+            }
+            snprintf(name, sizeof(name), "render_%s_%s", diff ? "diff" : "full", modes[m]);
+            run_benchmark(name, 1, chunk_render, &context);
+            renderer_free(&context.renderer);
+        }
+    }
+    close(fd);
+}
+
+/*
+ * Name    : main
+ * Purpose : Entry point for histo-bench
+ * Input   : Command-line arguments [-t seconds] [-p max_producers] [-f name_filter]
+ * Outputs : One JSON line per benchmark on stdout
+ * Returns : EXIT_SUCCESS, or EXIT_FAILURE on invalid arguments
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:p:f:")) != -1) {
+        switch (opt) {
+        case 't':
+            bench_seconds = atof(optarg);
+            break;
+        case 'p':
+            bench_max_producers = atoi(optarg);
+            break;
+        case 'f':
+            bench_filter = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-t seconds] [-p max_producers] [-f name_filter]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (bench_seconds <= 0 || bench_max_producers < 1) {
+        fprintf(stderr, "histo-bench: Time and producer count must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_ring_ops();
+    bench_records();
+    bench_producer_scaling();
+    bench_counting();
+    bench_rendering();
+
+    return EXIT_SUCCESS;
+}
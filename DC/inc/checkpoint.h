@@ -0,0 +1,64 @@
+/*
+ * FILE: checkpoint.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header file declares DC's checkpoint file. With a checkpoint, DC's all-time counts and
+ * window buckets do not live in DC's memory but in a MAP_SHARED mapping of the file, so they
+ * outlive the process: if DC dies, the page cache still holds every count up to its last read
+ * pass, and a restarted DC maps the file and carries on in constant time. The header records the
+ * ring the counts came from and each lane's read position after DC's last read pass, which a DC
+ * resuming on the same ring reads on from. Every flush interval DC stores a checksum of the state
+ * and schedules write-back (msync); the checksum is what a DC trusts after a reboot or a clean
+ * exit, when the page cache is not known to be current.
+ */
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "../../common/inc/common.h"
+#include "../../common/inc/shared_memory.h"
+#include "../../common/inc/sliding_window.h"
+#include <stdint.h>
+
+// File identification
+#define CHECKPOINT_MAGIC 0x48434b50u  // "HCKP"
+#define CHECKPOINT_VERSION 1          // Bump whenever checkpoint_t changes
+#define CHECKPOINT_BOOT_ID_SIZE 40    // /proc/sys/kernel/random/boot_id plus terminator
+
+// Flush interval in milliseconds unless -f or HISTO_CHECKPOINT_MS says otherwise
+#define CHECKPOINT_DEFAULT_FLUSH_MS 1000
+
+// Checkpoint header, followed by the state it describes
+typedef struct {
+    uint32_t magic;                 // CHECKPOINT_MAGIC
+    uint32_t version;               // CHECKPOINT_VERSION
+    uint32_t symbol_bins;           // LETTER_RANGE of the writing binary
+    uint32_t window_buckets;        // WINDOW_BUCKETS of the writing binary
+    uint64_t file_size;             // sizeof(checkpoint_t)
+    uint64_t flushes;               // Flushes since the file was created
+    uint64_t checksum;              // Checksum of the state as of the last flush
+    uint32_t clean;                 // 1 once DC has exited and made its final flush
+    uint32_t lane_count;            // Lanes of the ring the positions refer to
+    int64_t ring_shmid;             // Identity of that ring: shmid and creation time
+    int64_t ring_ctime;
+    int64_t touched_unix_ns;        // CLOCK_REALTIME of the last window bucket close, ages the windows on resume
+    char boot_id[CHECKPOINT_BOOT_ID_SIZE];    // Kernel boot whose page cache holds the live state
+    uint64_t lane_positions[MAX_PRODUCERS];  // Each lane's read_index after DC's last read pass
+} checkpoint_header_t;
+
+// Whole checkpoint file
+typedef struct {
+    checkpoint_header_t header;
+    _Alignas(CACHE_LINE_SIZE) uint64_t letter_counts[LETTER_RANGE];  // DC's all-time counts
+    window_set_t windows;                                           // DC's rolling windows
+} checkpoint_t;
+
+// Functions
+checkpoint_t *open_checkpoint(const char *path, shared_memory_t *shm, int ring_shmid);
+void checkpoint_positions(checkpoint_t *checkpoint, const shared_memory_t *shm);
+void checkpoint_bucket_closed(checkpoint_t *checkpoint);
+void checkpoint_flush(checkpoint_t *checkpoint);
+void close_checkpoint(checkpoint_t *checkpoint);
+
+#endif /* CHECKPOINT_H */
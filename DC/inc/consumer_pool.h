@@ -0,0 +1,68 @@
+/*
+ * FILE: consumer_pool.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header file declares DC's consumer thread pool. With -T (or HISTO_DC_THREADS) the lanes are
+ * split between several consumer threads: thread t owns lanes t, t + threads, t + 2 * threads, ...
+ * and counts them into a partial histogram of its own, on cache lines no other thread writes.
+ * The event loop starts a read pass on every thread at once and hears back through an eventfd
+ * when the last one is done. The partial histograms are only added to DC's counts and windows
+ * when DC needs them (snapshot, display, window bucket close, checkpoint flush, and every read
+ * pass when there is a checkpoint), so no counter is ever shared between the threads.
+ */
+#ifndef CONSUMER_POOL_H
+#define CONSUMER_POOL_H
+
+#include "../../common/inc/common.h"
+#include "../../common/inc/shared_memory.h"
+#include "../../common/inc/sliding_window.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Most consumer threads (each needs at least one lane)
+#define DC_MAX_THREADS MAX_PRODUCERS
+
+struct consumer_pool;
+
+// One consumer thread, its lanes and its partial histogram
+typedef struct {
+    // Written only by this thread (load and store, no read-modify-write), read by the merge
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t counts[LETTER_RANGE];
+    _Atomic uint64_t letters;  // Letters counted since DC started
+    uint64_t pass_letters;     // Letters counted by the last read pass
+    unsigned int pass_seq;     // Last read pass this thread ran
+    int first_lane;            // Lanes first_lane, first_lane + threads, ...
+    int next_lane;             // Fair start position within those lanes
+    pthread_t thread;
+    struct consumer_pool *pool;
+    // Merge side only: the part of counts already added to DC's histogram
+    _Alignas(CACHE_LINE_SIZE) uint64_t merged[LETTER_RANGE];
+} consumer_worker_t;
+
+// The pool, owned by the event loop
+typedef struct consumer_pool {
+    shared_memory_t *shm;
+    int semid;
+    int threads;
+    int done_fd;                 // eventfd: written by the last thread to finish a read pass
+    int busy;                    // A read pass is running (event loop only)
+    consumer_worker_t *workers;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint pass_seq;  // Futex the threads sleep on, bumped per read pass
+    atomic_int running_threads;  // Threads still in the current read pass
+    atomic_int stop;             // Tells the threads to exit
+} consumer_pool_t;
+
+// Functions
+int consumer_pool_start(consumer_pool_t *pool, shared_memory_t *shm, int semid, int threads);
+int consumer_pool_dispatch(consumer_pool_t *pool);
+uint64_t consumer_pool_pass_done(consumer_pool_t *pool);
+void consumer_pool_merge(consumer_pool_t *pool, uint64_t *letter_counts, window_set_t *windows);
+void consumer_pool_stop(consumer_pool_t *pool, uint64_t *letter_counts, window_set_t *windows);
+void *consumer_worker_main(void *arg);
+void worker_count_letters(const symbol_t *letters, int count);
+void worker_count_packed(const uint64_t *words, int count);
+
+#endif /* CONSUMER_POOL_H */
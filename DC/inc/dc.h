@@ -5,8 +5,9 @@
  * FIRST VERSION: 08-04-2025
  * DESCRIPTION:
  * This header file declares the function prototypes and global variables
- * used by the DC (Data Consumer) component. It includes signal handlers,
- * histogram logic, and IPC-related shared variables.
+ * used by the DC (Data Consumer) component. It includes the epoll event loop,
+ * histogram logic, and IPC-related shared variables. The consumer thread pool used
+ * with -T is declared in consumer_pool.h.
  * REFERENCES:
  * https://medium.com/@razika28/signals-ad83f38f80b6 
  * https://www.tutorialspoint.com/c_standard_library/c_function_signal.htm 
@@ -16,32 +17,73 @@
 #ifndef DC_H
 #define DC_H
 
+#include "../../common/inc/common.h"  // Symbol domain: MIN_LETTER, MAX_LETTER, LETTER_RANGE, symbol_t
+#include "../../common/inc/circular_buffer.h"  // record_batch_t
 #include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <sys/types.h>
 
-// Letter range constants
-#define MIN_LETTER 'A'
-#define MAX_LETTER 'T'
-#define LETTER_RANGE (MAX_LETTER - MIN_LETTER + 1)
+// Per-letter rate columns in the window table, only while they fit on a line
+#define WINDOW_LETTER_COLUMNS (LETTER_RANGE <= 20)
 
+// Consumer modes
+#define DC_MODE_ALARM 0  // Read READ_BATCH_SIZE letters per 2-second read timer (original behaviour)
+#define DC_MODE_EVENT 1  // Sleep on the ring futex (via the bridge thread) and drain to empty on every wakeup
 
-// Signal handlers
-void sigint_handler(int signum);
-void sigalrm_handler(int signum);
+// Timer intervals in seconds
+#define READ_INTERVAL 2      // Alarm-mode read cadence, event-mode sweep for letters below the threshold
+#define DISPLAY_INTERVAL 10  // Histogram display cadence
+#define SNAPSHOT_INTERVAL_MS 100  // Snapshot publishing cadence (milliseconds)
+
+// Event sources in the epoll loop (epoll_event.data.u32)
+#define EVENT_SIGNAL 0         // signalfd: SIGINT
+#define EVENT_READ_TIMER 1     // timerfd: every READ_INTERVAL seconds
+#define EVENT_DISPLAY_TIMER 2  // timerfd: every DISPLAY_INTERVAL seconds
+#define EVENT_DATA 3           // eventfd: futex bridge saw a lane reach the wake threshold
+#define EVENT_BUCKET_TIMER 4   // timerfd: close the current sliding-window bucket every second
+#define EVENT_SNAPSHOT_TIMER 5 // timerfd: publish the snapshot region every SNAPSHOT_INTERVAL_MS
+#define EVENT_CHECKPOINT_TIMER 6  // timerfd: seal and write back the checkpoint file (only with -c)
+#define EVENT_PASS_DONE 7      // eventfd: the consumer threads finished a read pass (only with -T)
+#define EVENT_SOURCE_COUNT 8
+
+// Event loop and its handlers
+int run_event_loop(void);
+int read_tick(void);
+int drain_buffer(void);
+void start_read_pass(void);
+void shutdown_drain(void);
+void *futex_bridge(void *arg);
+int create_interval_timer(long milliseconds);
+int watch_fd(int epoll_fd, int fd, uint32_t source);
+void update_letter_counts(const symbol_t *letters, int count);
+void update_packed_counts(const uint64_t *words, int count);
+void unpack_tick_words(const uint64_t *words, int count);
+int drain_records(void);
+int drain_packed(void);
+int record_keys(const record_batch_t *batch, symbol_t *keys);
+void record_latencies(const record_batch_t *batch);
 
 // Function to display histogram
+void merge_partials(void);
 void display_histogram(void);
+void display_window_stats(void);
+void display_latency_stats(void);
+void publish_dc_snapshot(int dc_running);
+void display_producer_stats(void);
 
 // Function to clean up and exit
 void cleanup_and_exit(void);
 
 // Global variables
-extern volatile sig_atomic_t running; // Used in signal handlers and main loop to control program flow
-extern volatile sig_atomic_t cleanup_mode; // Indicates cleanup mode across signal handler and main logic
+extern volatile sig_atomic_t running; // Controls the event loop
+extern volatile sig_atomic_t cleanup_mode; // Set once SIGINT has been received and producers signalled
 extern int shmid; // Shared memory ID needed in multiple functions
 extern int semid;  // Semaphore ID accessed by reading and cleanup functions
-extern pid_t dp1_pid;  // Required to send SIGINT to DP-1 during shutdown
-extern pid_t dp2_pid; // Required to send SIGINT to DP-2 during shutdown
-extern int letter_counts[LETTER_RANGE];  // Stores histogram data used by multiple functions
+extern uint64_t *letter_counts;  // Stores histogram data used by multiple functions (LETTER_RANGE counts)
+extern int consumer_mode;  // DC_MODE_ALARM or DC_MODE_EVENT, chosen at startup
+extern int data_event_fd;  // eventfd the futex bridge signals when data is ready
+extern int drained_event_fd;  // eventfd the loop signals after draining
+extern atomic_int bridge_stop;  // Tells the futex bridge thread to exit
 
 #endif /* DC_H */
\ No newline at end of file
@@ -0,0 +1,340 @@
+/*
+ * FILE: checkpoint.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This file implements DC's checkpoint file (see checkpoint.h). Opening it decides whether the
+ * state in the file can be resumed:
+ * - left by a DC that died during this boot: the mapping is exactly what that DC last wrote, so it
+ *   is resumed as is (only a read pass cut short between counting and releasing can be counted twice);
+ * - left by a clean exit or before a reboot: resumed only if it matches the checksum of its last
+ *   flush, otherwise DC starts from zero and says why.
+ * The windows are then aged by the time the file was idle, as if DC had kept closing buckets, and
+ * on the same ring the lanes are moved up to the recorded read positions, so letters already in the
+ * counts are not read a second time.
+ * Nothing on the read path touches the file beyond the counters themselves and, once per read
+ * pass, the lane positions.
+ */
+#define _DEFAULT_SOURCE  // Enables ftruncate, msync and clock_gettime
+
+#include "../inc/checkpoint.h"
+#include "../../common/inc/circular_buffer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+
+#define CHECKSUM_SEED 0xcbf29ce484222325ULL   // FNV-1a offset basis
+#define CHECKSUM_PRIME 0x100000001b3ULL       // FNV-1a prime
+
+/*
+ * Name    : state_checksum
+ * Purpose : FNV-1a over the 64-bit words of the counts and windows
+ * Input   : Checkpoint
+ * Outputs : None
+ * Returns : Checksum
+ */
+static uint64_t state_checksum(const checkpoint_t *checkpoint) {
+    const uint64_t *word = checkpoint->letter_counts;
+    const uint64_t *end = (const uint64_t *)((const char *)checkpoint + sizeof(*checkpoint));
+    uint64_t hash = CHECKSUM_SEED;
+
+    // letter_counts and windows run to the end of the struct, whose size is a multiple of 8
+    for (; word < end; word++) {
+        hash = (hash ^ *word) * CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+/*
+ * Name    : unix_time_ns
+ * Purpose : Wall-clock time, the only clock that still means something after a restart or reboot
+ * Input   : None
+ * Outputs : None
+ * Returns : CLOCK_REALTIME in nanoseconds
+ */
+static int64_t unix_time_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Name    : read_boot_id
+ * Purpose : Identify the running kernel boot
+ * Input   : Destination of CHECKPOINT_BOOT_ID_SIZE bytes
+ * Outputs : Boot id, or an empty string if it is unavailable
+ * Returns : None
+ */
+static void read_boot_id(char *boot_id) {
+    FILE *file = fopen("/proc/sys/kernel/random/boot_id", "r");
+
+    memset(boot_id, 0, CHECKPOINT_BOOT_ID_SIZE);
+    if (file != NULL) {
+        if (fgets(boot_id, CHECKPOINT_BOOT_ID_SIZE, file) != NULL) {
+            boot_id[strcspn(boot_id, "\n")] = '\0';
+        }
+        fclose(file);
+    }
+}
+
+/*
+ * Name    : ring_identity
+ * Purpose : Tell rings apart: a new DP-1 run creates a new segment even if it reuses the shmid
+ * Input   : Ring shmid, where to store its creation time
+ * Outputs : Creation time (0 if unknown)
+ * Returns : None
+ */
+static void ring_identity(int ring_shmid, int64_t *ctime) {
+    struct shmid_ds info;
+
+    *ctime = (shmctl(ring_shmid, IPC_STAT, &info) == 0) ? (int64_t)info.shm_ctime : 0;
+}
+
+/*
+ * Name    : header_matches
+ * Purpose : Check a mapped file was written by a DC with this binary's layout
+ * Input   : Checkpoint
+ * Outputs : None
+ * Returns : 1 if the layout matches
+ */
+static int header_matches(const checkpoint_t *checkpoint) {
+    const checkpoint_header_t *header = &checkpoint->header;
+
+    return header->magic == CHECKPOINT_MAGIC && header->version == CHECKPOINT_VERSION &&
+           header->symbol_bins == LETTER_RANGE && header->window_buckets == WINDOW_BUCKETS &&
+           header->file_size == sizeof(checkpoint_t);
+}
+
+/*
+ * Name    : reset_checkpoint
+ * Purpose : Start a checkpoint from zero
+ * Input   : Checkpoint
+ * Outputs : Header stamped, counts and windows cleared
+ * Returns : None
+ */
+static void reset_checkpoint(checkpoint_t *checkpoint) {
+    memset(checkpoint, 0, sizeof(*checkpoint));
+    checkpoint->header.magic = CHECKPOINT_MAGIC;
+    checkpoint->header.version = CHECKPOINT_VERSION;
+    checkpoint->header.symbol_bins = LETTER_RANGE;
+    checkpoint->header.window_buckets = WINDOW_BUCKETS;
+    checkpoint->header.file_size = sizeof(checkpoint_t);
+    windows_init(&checkpoint->windows);
+    checkpoint->header.checksum = state_checksum(checkpoint);
+}
+
+/*
+ * Name    : resume_state
+ * Purpose : Decide whether the state found in the file can be trusted
+ * Input   : Checkpoint, path (for messages), current boot id
+ * Outputs : Message on stdout
+ * Returns : 1 if the state is resumed, 0 if it has to be discarded
+ */
+static int resume_state(const checkpoint_t *checkpoint, const char *path, const char *boot_id) {
+    const checkpoint_header_t *header = &checkpoint->header;
+
+    if (!header->clean && boot_id[0] != '\0' && strcmp(header->boot_id, boot_id) == 0) {
+        printf("DC: %s was left by a DC that stopped unexpectedly, resuming its live state\n", path);
+        return 1;
+    }
+    if (state_checksum(checkpoint) != header->checksum) {
+        printf("DC: %s does not match the checksum of its last flush, starting from zero\n", path);
+        return 0;
+    }
+    printf("DC: Resuming %s as of flush %llu\n", path, (unsigned long long)header->flushes);
+    return 1;
+}
+
+/*
+ * Name    : resume_positions
+ * Purpose : Line the same ring up with the checkpoint's lane positions before DC reads again. A lane
+ *           behind its recorded position still holds letters the checkpoint has counted, so it is
+ *           moved up to it; a lane ahead of it released letters after the last recorded read pass,
+ *           which the dead DC may not have added to the file (a pool partial), so they are reported
+ * Input   : Checkpoint of this ring, ring
+ * Outputs : read_index of lanes behind their position moved up, summary printed
+ * Returns : 1 if the positions fit the ring, 0 if a lane is behind and short of its recorded
+ *           position (the ring was reset in place, nothing is moved)
+ */
+static int resume_positions(checkpoint_t *checkpoint, shared_memory_t *shm) {
+    const checkpoint_header_t *header = &checkpoint->header;
+    uint64_t released = 0;
+    uint64_t skipped = 0;
+
+    for (uint32_t lane = 0; lane < header->lane_count; lane++) {
+        uint64_t read = atomic_load_explicit(&shm->lanes[lane].read_index, memory_order_acquire);
+
+        if (read < header->lane_positions[lane] &&
+            atomic_load_explicit(&shm->lanes[lane].write_index, memory_order_acquire) < header->lane_positions[lane]) {
+            printf("DC: Lane %u of the ring is short of the checkpoint's position, not resuming positions\n", lane);
+            return 0;
+        }
+    }
+
+    for (uint32_t lane = 0; lane < header->lane_count; lane++) {
+        ring_lane_t *ring_lane = &shm->lanes[lane];
+        uint64_t read = atomic_load_explicit(&ring_lane->read_index, memory_order_acquire);
+
+        // Only an overwriting producer moves read_index besides us, and only forward
+        while (read < header->lane_positions[lane] &&
+               !atomic_compare_exchange_weak_explicit(&ring_lane->read_index, &read, header->lane_positions[lane],
+                                                      memory_order_acq_rel, memory_order_acquire)) {
+        }
+        if (read < header->lane_positions[lane]) {
+            skipped += header->lane_positions[lane] - read;
+        } else {
+            released += read - header->lane_positions[lane];
+        }
+    }
+    printf("DC: Same ring as the checkpoint, skipped %llu %s it already counted, %llu %s released after its "
+           "last recorded read pass\n", (unsigned long long)skipped, ring_unit_name(shm->ring_format),
+           (unsigned long long)released, ring_unit_name(shm->ring_format));
+    return 1;
+}
+
+/*
+ * Name    : open_checkpoint
+ * Purpose : Map (creating it if needed) the checkpoint file and resume the state it holds
+ * Input   : File path, attached ring, ring shmid
+ * Outputs : Counts and windows resumed or reset, windows aged by the idle time, lanes moved up to
+ *           the recorded positions (see resume_positions)
+ * Returns : Mapped checkpoint, or NULL if the file cannot be used
+ */
+checkpoint_t *open_checkpoint(const char *path, shared_memory_t *shm, int ring_shmid) {
+    checkpoint_t *checkpoint;
+    checkpoint_header_t *header;
+    struct stat info;
+    char boot_id[CHECKPOINT_BOOT_ID_SIZE];
+    int64_t ring_ctime;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (fd == -1 || fstat(fd, &info) == -1) {
+        fprintf(stderr, "DC: Cannot open checkpoint %s: %s\n", path, strerror(errno));
+        if (fd != -1) {
+            close(fd);
+        }
+        return NULL;
+    }
+    if ((size_t)info.st_size != sizeof(checkpoint_t) && ftruncate(fd, (off_t)sizeof(checkpoint_t)) == -1) {
+        fprintf(stderr, "DC: Cannot size checkpoint %s: %s\n", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    checkpoint = mmap(NULL, sizeof(checkpoint_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file
+    if (checkpoint == MAP_FAILED) {
+        fprintf(stderr, "DC: Cannot map checkpoint %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    header = &checkpoint->header;
+
+    // Resume or start over
+    read_boot_id(boot_id);
+    if (info.st_size == 0) {
+        reset_checkpoint(checkpoint);
+    } else if (!header_matches(checkpoint)) {
+        printf("DC: %s was written by a different build, starting from zero\n", path);
+        reset_checkpoint(checkpoint);
+    } else if (!resume_state(checkpoint, path, boot_id)) {
+        reset_checkpoint(checkpoint);
+    } else if (header->touched_unix_ns > 0) {
+        // Close the buckets DC would have closed while it was away (empty, nothing was counted)
+        int64_t idle_ns = unix_time_ns() - header->touched_unix_ns;
+        int64_t missed = (idle_ns > 0) ? idle_ns / (WINDOW_BUCKET_SECONDS * 1000000000LL) : 0;
+
+        for (int64_t bucket = 0; bucket < missed && bucket <= WINDOW_BUCKETS; bucket++) {
+            windows_rotate(&checkpoint->windows);
+        }
+    }
+
+    // Lane positions only carry over to the same ring; a recreated ring starts at zero
+    ring_identity(ring_shmid, &ring_ctime);
+    if (header->ring_shmid != ring_shmid || header->ring_ctime != ring_ctime ||
+        header->lane_count != shm->header.lane_count || !resume_positions(checkpoint, shm)) {
+        header->ring_shmid = ring_shmid;
+        header->ring_ctime = ring_ctime;
+        header->lane_count = shm->header.lane_count;
+    }
+    checkpoint_positions(checkpoint, shm);
+
+    memcpy(header->boot_id, boot_id, sizeof(header->boot_id));
+    header->clean = 0;
+    header->touched_unix_ns = unix_time_ns();
+    return checkpoint;
+}
+
+/*
+ * Name    : checkpoint_positions
+ * Purpose : Record each lane's read position after a read pass
+ * Input   : Checkpoint (NULL when DC runs without one), ring
+ * Outputs : lane_positions updated
+ * Returns : None
+ */
+void checkpoint_positions(checkpoint_t *checkpoint, const shared_memory_t *shm) {
+    if (checkpoint == NULL) {
+        return;
+    }
+    for (uint32_t lane = 0; lane < checkpoint->header.lane_count; lane++) {
+        checkpoint->header.lane_positions[lane] =
+            atomic_load_explicit(&shm->lanes[lane].read_index, memory_order_relaxed);
+    }
+}
+
+/*
+ * Name    : checkpoint_bucket_closed
+ * Purpose : Remember when a window bucket was last closed, to age the windows after a restart
+ * Input   : Checkpoint (NULL when DC runs without one)
+ * Outputs : touched_unix_ns updated
+ * Returns : None
+ */
+void checkpoint_bucket_closed(checkpoint_t *checkpoint) {
+    if (checkpoint != NULL) {
+        checkpoint->header.touched_unix_ns = unix_time_ns();
+    }
+}
+
+/*
+ * Name    : checkpoint_flush
+ * Purpose : Seal the current state with a checksum and schedule its write-back
+ * Input   : Checkpoint (NULL when DC runs without one)
+ * Outputs : checksum and flushes updated, dirty pages queued for writing
+ * Returns : None
+ */
+void checkpoint_flush(checkpoint_t *checkpoint) {
+    if (checkpoint == NULL) {
+        return;
+    }
+    checkpoint->header.checksum = state_checksum(checkpoint);
+    checkpoint->header.flushes++;
+    if (msync(checkpoint, sizeof(*checkpoint), MS_ASYNC) == -1) {
+        perror("DC: msync(checkpoint)");
+    }
+}
+
+/*
+ * Name    : close_checkpoint
+ * Purpose : Final flush on an orderly exit, written through before DC exits
+ * Input   : Checkpoint (NULL when DC runs without one)
+ * Outputs : File marked clean, checkpoint unmapped
+ * Returns : None
+ */
+void close_checkpoint(checkpoint_t *checkpoint) {
+    if (checkpoint == NULL) {
+        return;
+    }
+    checkpoint->header.touched_unix_ns = unix_time_ns();
+    checkpoint->header.clean = 1;
+    checkpoint_flush(checkpoint);
+    if (msync(checkpoint, sizeof(*checkpoint), MS_SYNC) == -1) {
+        perror("DC: msync(checkpoint)");
+    }
+    munmap(checkpoint, sizeof(*checkpoint));
+}
@@ -0,0 +1,299 @@
+/*
+ * FILE: consumer_pool.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This file implements DC's consumer thread pool (see consumer_pool.h). Each thread sleeps on a
+ * private futex word until the event loop starts a read pass, drains its own lanes to empty with
+ * consume_from_lane_set (or consume_packed_from_lane_set), counting in place into its partial
+ * histogram, and the last thread to finish signals the loop's eventfd. A partial counter is only
+ * ever written by its own thread, so it is updated with a plain load and store like the producer
+ * counters in shared memory; the merge reads it with relaxed loads and adds what is new since the
+ * previous merge.
+ */
+#define _GNU_SOURCE  // Enables eventfd
+
+#include "../inc/consumer_pool.h"
+#include "../../common/inc/circular_buffer.h"
+#include "../../common/inc/histogram_kernel.h"
+#include "../../common/inc/futex_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// Most letters (packed words in packed format) counted in place per pass, as in DC's own drain
+#define WORKER_BATCH_SIZE 4096
+
+// The thread the counting callbacks run on, which the ring's callback type cannot pass
+static _Thread_local consumer_worker_t *current_worker = NULL;
+
+/*
+ * Name    : partial_add
+ * Purpose : Add to a counter only the calling thread writes (no read-modify-write needed)
+ * Input   : Counter, amount
+ * Outputs : Counter updated
+ * Returns : None
+ */
+static inline void partial_add(_Atomic uint64_t *counter, uint64_t amount) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+/*
+ * Name    : worker_count_letters
+ * Purpose : Counting callback: add a run of letters to the current thread's partial histogram
+ * Input   : Letter array, number of letters
+ * Outputs : The thread's counts and letters updated (letters outside the domain are not binned)
+ * Returns : None
+ */
+void worker_count_letters(const symbol_t *letters, int count) {
+    consumer_worker_t *worker = current_worker;
+
+#if LETTER_RANGE > 256
+    // 16-bit domain: a run touches few of the bins, so add letter by letter
+    for (int i = 0; i < count; i++) {
+        unsigned int bin = (unsigned int)(letters[i] - MIN_LETTER);
+
+        if (bin < LETTER_RANGE) {
+            partial_add(&worker->counts[bin], 1);
+        }
+    }
+#else
+    uint64_t batch_counts[LETTER_RANGE] = {0};
+
+    (void)count_letters(letters, (size_t)count, batch_counts);
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        if (batch_counts[i] != 0) {
+            partial_add(&worker->counts[i], batch_counts[i]);
+        }
+    }
+#endif
+    partial_add(&worker->letters, (uint64_t)count);
+}
+
+/*
+ * Name    : worker_count_packed
+ * Purpose : Counting callback, packed format: add a run of packed words to the current thread's
+ *           partial histogram without unpacking them
+ * Input   : Packed words, number of words
+ * Outputs : The thread's counts and letters updated (padding is not counted)
+ * Returns : None
+ */
+void worker_count_packed(const uint64_t *words, int count) {
+#if LETTER_RANGE > 256
+    // No packed ring in this domain (see PACKED_RING_SUPPORTED), unpack for the letter path
+    symbol_t letters[PACKED_PER_WORD];
+
+    for (int i = 0; i < count; i++) {
+        worker_count_letters(letters, unpack_letters(&words[i], 1, letters));
+    }
+#else
+    consumer_worker_t *worker = current_worker;
+    uint64_t batch_counts[LETTER_RANGE] = {0};
+    size_t fields = (size_t)count * PACKED_PER_WORD;
+
+    // Padding fields are outside the domain, so the kernel reports them as rejected
+    partial_add(&worker->letters, fields - count_packed_letters(words, fields, batch_counts));
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        if (batch_counts[i] != 0) {
+            partial_add(&worker->counts[i], batch_counts[i]);
+        }
+    }
+#endif
+}
+
+/*
+ * Name    : worker_drain
+ * Purpose : One read pass of one thread: count every letter currently in its lanes
+ * Input   : Consumer thread
+ * Outputs : The thread's lanes emptied, its partial histogram updated
+ * Returns : Number of letters counted
+ */
+static uint64_t worker_drain(consumer_worker_t *worker) {
+    consumer_pool_t *pool = worker->pool;
+    uint64_t before = atomic_load_explicit(&worker->letters, memory_order_relaxed);
+    int num_read;
+
+    do {
+        ring_lock(pool->shm, pool->semid);
+        if (pool->shm->ring_format == RING_FORMAT_PACKED) {
+            num_read = consume_packed_from_lane_set(pool->shm, worker->first_lane, pool->threads, &worker->next_lane,
+                                                    WORKER_BATCH_SIZE, worker_count_packed);
+        } else {
+            num_read = consume_from_lane_set(pool->shm, worker->first_lane, pool->threads, &worker->next_lane,
+                                             WORKER_BATCH_SIZE, worker_count_letters);
+        }
+        ring_unlock(pool->shm, pool->semid);
+    } while (num_read == WORKER_BATCH_SIZE);
+
+    return atomic_load_explicit(&worker->letters, memory_order_relaxed) - before;
+}
+
+/*
+ * Name    : consumer_worker_main
+ * Purpose : Consumer thread: run a read pass every time the event loop starts one, until stopped
+ * Input   : Its consumer_worker_t
+ * Outputs : done_fd signalled by the last thread to finish each pass
+ * Returns : NULL
+ */
+void *consumer_worker_main(void *arg) {
+    consumer_worker_t *worker = arg;
+    consumer_pool_t *pool = worker->pool;
+
+    current_worker = worker;
+    for (;;) {
+        unsigned int seq = atomic_load_explicit(&pool->pass_seq, memory_order_acquire);
+
+        if (atomic_load(&pool->stop)) {
+            break;
+        }
+        if (seq == worker->pass_seq) {
+            futex_wait(&pool->pass_seq, seq, NULL);
+            continue;
+        }
+
+        worker->pass_seq = seq;
+        worker->pass_letters = worker_drain(worker);
+        if (atomic_fetch_sub_explicit(&pool->running_threads, 1, memory_order_acq_rel) == 1) {
+            eventfd_write(pool->done_fd, 1);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Name    : consumer_pool_start
+ * Purpose : Create the pool's eventfd and start its consumer threads
+ * Input   : Pool, ring, semaphore ID, number of threads (1 to the ring's lane count)
+ * Outputs : Threads sleeping until the first read pass
+ * Returns : 0 on success, -1 on error (nothing is left running)
+ */
+int consumer_pool_start(consumer_pool_t *pool, shared_memory_t *shm, int semid, int threads) {
+    memset(pool, 0, sizeof(*pool));
+    pool->shm = shm;
+    pool->semid = semid;
+    pool->done_fd = eventfd(0, EFD_CLOEXEC);
+    pool->workers = aligned_alloc(CACHE_LINE_SIZE, (size_t)threads * sizeof(*pool->workers));
+    if (pool->done_fd == -1 || pool->workers == NULL) {
+        perror("DC: consumer pool setup");
+        if (pool->done_fd != -1) {
+            close(pool->done_fd);
+        }
+        free(pool->workers);
+        return -1;
+    }
+    memset(pool->workers, 0, (size_t)threads * sizeof(*pool->workers));
+
+    for (int t = 0; t < threads; t++) {
+        consumer_worker_t *worker = &pool->workers[t];
+
+        worker->first_lane = t;
+        worker->pool = pool;
+        if (pthread_create(&worker->thread, NULL, consumer_worker_main, worker) != 0) {
+            perror("DC: consumer thread");
+            consumer_pool_stop(pool, NULL, NULL);
+            return -1;
+        }
+        pool->threads = t + 1;
+    }
+    // Every thread owns lanes t, t + threads, ... of the final thread count
+    pool->threads = threads;
+    return 0;
+}
+
+/*
+ * Name    : consumer_pool_dispatch
+ * Purpose : Start a read pass on every consumer thread, unless one is still running
+ * Input   : Pool
+ * Outputs : Threads woken
+ * Returns : 1 if a pass was started, 0 if the previous one has not finished yet
+ */
+int consumer_pool_dispatch(consumer_pool_t *pool) {
+    if (pool->busy) {
+        return 0;
+    }
+    pool->busy = 1;
+    atomic_store_explicit(&pool->running_threads, pool->threads, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->pass_seq, 1, memory_order_release);
+    futex_wake(&pool->pass_seq);
+    return 1;
+}
+
+/*
+ * Name    : consumer_pool_pass_done
+ * Purpose : Event-loop side of done_fd: finish the read pass that just ended
+ * Input   : Pool
+ * Outputs : done_fd read, pool ready for the next pass
+ * Returns : Letters counted by the pass, over all threads
+ */
+uint64_t consumer_pool_pass_done(consumer_pool_t *pool) {
+    eventfd_t passes;
+    uint64_t total = 0;
+
+    eventfd_read(pool->done_fd, &passes);
+    // The last thread's decrement ordered every other thread's pass_letters before its eventfd write
+    atomic_thread_fence(memory_order_acquire);
+    for (int t = 0; t < pool->threads; t++) {
+        total += pool->workers[t].pass_letters;
+    }
+    pool->busy = 0;
+    return total;
+}
+
+/*
+ * Name    : consumer_pool_merge
+ * Purpose : Add what the threads have counted since the last merge to DC's counts and current window bucket
+ * Input   : Pool (NULL when DC runs single-threaded), DC's counts, DC's windows
+ * Outputs : letter_counts and windows updated
+ * Returns : None
+ */
+void consumer_pool_merge(consumer_pool_t *pool, uint64_t *letter_counts, window_set_t *windows) {
+    static uint64_t batch_counts[LETTER_RANGE];  // Static: with a wide symbol domain it is too big for the stack
+
+    if (pool == NULL || pool->workers == NULL) {
+        return;
+    }
+
+    memset(batch_counts, 0, sizeof(batch_counts));
+    for (int t = 0; t < pool->threads; t++) {
+        consumer_worker_t *worker = &pool->workers[t];
+
+        for (int i = 0; i < LETTER_RANGE; i++) {
+            uint64_t now = atomic_load_explicit(&worker->counts[i], memory_order_relaxed);
+
+            batch_counts[i] += now - worker->merged[i];
+            worker->merged[i] = now;
+        }
+    }
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        letter_counts[i] += batch_counts[i];
+    }
+    windows_add(windows, batch_counts);
+}
+
+/*
+ * Name    : consumer_pool_stop
+ * Purpose : Stop and join the consumer threads, merge what they counted last and free the pool
+ * Input   : Pool, DC's counts and windows (NULL to skip the merge)
+ * Outputs : Threads gone, letter_counts and windows updated
+ * Returns : None
+ */
+void consumer_pool_stop(consumer_pool_t *pool, uint64_t *letter_counts, window_set_t *windows) {
+    atomic_store(&pool->stop, 1);
+    atomic_fetch_add_explicit(&pool->pass_seq, 1, memory_order_release);
+    futex_wake(&pool->pass_seq);
+    for (int t = 0; t < pool->threads; t++) {
+        pthread_join(pool->workers[t].thread, NULL);
+    }
+
+    if (letter_counts != NULL) {
+        consumer_pool_merge(pool, letter_counts, windows);
+    }
+    close(pool->done_fd);
+    free(pool->workers);
+    pool->workers = NULL;
+    pool->threads = 0;
+}
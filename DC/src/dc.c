@@ -9,15 +9,55 @@
  * The histogram is displayed every 10 seconds. On receiving SIGINT, the DC process initiates cleanup,
  * signals the producers to stop, drains the remaining buffer data, displays the final histogram,
  * and prints "Shazam !!" before exiting.
+ * Everything runs from one epoll loop in normal thread context: SIGINT arrives through a signalfd,
+ * and the 2-second read and 10-second display cadences are timerfds, so no real work happens in
+ * a signal handler. In event mode (the default) a small bridge thread sleeps on the shared-memory
+ * futex and signals an eventfd whenever the producers fill a lane past the wake threshold, and the
+ * loop drains the buffer to empty. Alarm mode keeps the original 40-letters-per-2-seconds reader.
+ * Letters are counted by the SIMD kernel in histogram_kernel.c (-k or HISTO_COUNT_KERNEL picks one),
+ * and the histogram is drawn by histogram_render.c in classic, log or auto bar mode (-b or HISTO_BAR_MODE).
+ * Counts are 64-bit; alongside the all-time totals DC keeps one-second buckets and reports the
+ * last 10 seconds, minute and 5 minutes as totals and per-letter rates (sliding_window.c).
+ * Every 100 ms DC publishes all of this, with ring statistics, to a seqlock-protected snapshot
+ * segment (snapshot.c) that the histo-view tool and other monitors read without disturbing DC.
+ * When the ring is in record format, DC dequeues framed records in batches and counts their key field.
+ * Each record carries its producer's CLOCK_MONOTONIC timestamp, so DC also keeps an HDR-style
+ * histogram of enqueue-to-count latency (latency_histogram.c) and reports p50/p99/p99.9/max.
+ * When the ring is in packed format, DC counts the 5-bit letters straight from the words in the
+ * lanes (count_packed_letters) and only unpacks them to print a read tick or to record them.
+ * DC keeps its own counters (letters read, read passes, wakeups, last read time) in the consumer
+ * block of the shared segment for histo-stat (ring_stats.c).
+ * With -c (or HISTO_CHECKPOINT) the all-time counts and window buckets live in a memory-mapped
+ * checkpoint file (checkpoint.c) instead of DC's memory, so a restarted DC resumes where the last
+ * one stopped; the file is sealed with a checksum and written back every flush interval (-f).
+ * With -w (or HISTO_LETTER_LOG) DC also records every letter it counts, in order, to a bit-packed
+ * letter log (letter_log.c) that DP-2 -P can replay into a ring later.
+ * With -T (or HISTO_DC_THREADS) the read passes are run by a pool of consumer threads instead
+ * (consumer_pool.c): each owns a share of the lanes and a partial histogram, and the partials are
+ * merged into the counts and windows only when they are shown, published or checkpointed.
  */
-#define _POSIX_C_SOURCE 200809L  // Enables POSIX-compliant features like sigaction 
+#define _GNU_SOURCE  // Enables epoll, timerfd, signalfd and eventfd
 
 #include "../inc/dc.h"
+#include "../inc/checkpoint.h"
+#include "../inc/consumer_pool.h"
 #include "../../common/inc/shared_memory.h"
 #include "../../common/inc/semaphore_utils.h"
 #include "../../common/inc/circular_buffer.h"
+#include "../../common/inc/producer_registry.h"
+#include "../../common/inc/histogram_kernel.h"
+#include "../../common/inc/futex_utils.h"
+#include "../../common/inc/histogram_render.h"
+#include "../../common/inc/sliding_window.h"
+#include "../../common/inc/snapshot.h"
+#include "../../common/inc/latency_histogram.h"
+#include "../../common/inc/ring_stats.h"
+#include "../../common/inc/letter_log.h"
 #include "../../common/inc/common.h"
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -26,148 +66,787 @@
 #include <time.h>
 #include <sys/ipc.h>
 #include <sys/sem.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 
 // Number of letters to read every 2 seconds 
 #define READ_BATCH_SIZE 40
+// Most letters (packed words in packed format) counted in place per pass while draining
+#define DRAIN_BATCH_SIZE 4096
+// Packed words unpacked at a time for the letter log
+#define UNPACK_BATCH_WORDS 256
+// How long to wait for late letters from stopping producers before the final histogram (ms)
+#define SHUTDOWN_GRACE_MS 100
+// How long to wait for every registered producer to exit during shutdown (seconds)
+#define PRODUCER_EXIT_TIMEOUT 2
 #define SEM_KEY 0x1234
 
 // Global variables
-// Used 'volatile sig_atomic_t' for safe, atomic access between main program and signal handlers
+// Kept as 'volatile sig_atomic_t' from the signal-handler days; SIGINT now arrives through a signalfd
 volatile sig_atomic_t running = 1;
 volatile sig_atomic_t cleanup_mode = 0; 
 int shmid = -1;
 int semid = -1;
-pid_t dp1_pid = -1;
-pid_t dp2_pid = -1;
 shared_memory_t *shm = NULL;
-int letter_counts[LETTER_RANGE] = {0};  // Counts for letters A-T
-time_t last_histogram_time = 0;  // Counter for 10-second histogram display
+uint64_t *letter_counts = NULL;  // All-time counts for letters A-T (or every symbol of the domain)
+window_set_t *windows = NULL;    // Rolling 10s / 1m / 5m counts
+checkpoint_t *checkpoint = NULL;  // Where letter_counts and windows live when DC checkpoints
+long checkpoint_flush_ms = CHECKPOINT_DEFAULT_FLUSH_MS;  // How often the checkpoint is sealed and written back
+letter_log_writer_t letter_log;  // Recording of the consumed stream
+letter_log_writer_t *recording = NULL;  // &letter_log while recording
+int consumer_mode = DC_MODE_EVENT;
+int next_lane = 0;  // Lane the next fair read starts from
+int data_event_fd = -1;     // Bridge -> loop: a lane reached the wake threshold
+int drained_event_fd = -1;  // Loop -> bridge: lanes drained, go back to sleep
+atomic_int bridge_stop = 0; // Set when the bridge thread should exit
+histogram_renderer_t renderer;  // Frame buffers for display_histogram
+record_batch_t record_batch;    // Batched dequeue destination in record format
+latency_histogram_t latency;    // Enqueue-to-count latency of every record counted (ns)
+uint64_t packed_letters = 0;    // Letters counted from packed words since DC started
+symbol_t tick_letters[READ_BATCH_SIZE];  // A read tick's letters unpacked from packed words
+int tick_letter_count = 0;
+snapshot_region_t *snapshot_region = NULL;  // Where monitoring tools read our state, if it could be created
+int snapshot_shmid = -1;
+uint64_t wakeups_total = 0;  // Data wakeups since DC started
+consumer_pool_t consumer_pool;  // Consumer threads with -T
+consumer_pool_t *consumers = NULL;  // &consumer_pool while the threads run the read passes
+int consumer_threads = 1;
+int pass_again = 0;  // A read pass was asked for while the threads were busy
 
 /*
- * Name    : sigint_handler
- * Purpose : Handles SIGINT for graceful shutdown
- * Input   : signum (signal number)
- * Outputs : Initiates cleanup and signals producers to stop
- * Returns : None
+ * Name    : read_tick
+ * Purpose : Read-timer handler: alarm mode reads and prints up to 40 letters, event mode drains
+ *           whatever is left below the wake threshold
+ * Input   : None
+ * Outputs : Reads buffer, updates letter counts
+ * Returns : Number of letters read
  */
-void sigint_handler(int signum) {
-    // Set cleanup mode 
-    cleanup_mode = 1;
-    
-    // Send SIGINT to producer processes
-    if (dp1_pid > 0) {
-        kill(dp1_pid, SIGINT);
-    }
-    if (dp2_pid > 0) {
-        kill(dp2_pid, SIGINT);
-    }
-}
+int read_tick(void) {
+    static int tick_count = 0;
+    symbol_t buffer[READ_BATCH_SIZE];
+    char label[16];
+    int num_read;
 
-/*
- * Name    : sigalrm_handler
- * Purpose : Triggered every 2 seconds to read data from buffer and update histogram
- * Input   : signum (signal number)
- * Outputs : Reads buffer, updates letter counts, optionally displays histogram
- * Returns : None
- */
-void sigalrm_handler(int signum) {
-    static int alarm_count = 0;
-    alarm_count++;
-    printf("SIGALRM triggered %d times\n", alarm_count);
+    if (consumer_mode == DC_MODE_EVENT) {
+        if (consumers != NULL) {
+            start_read_pass();  // Counted when the pass is done
+            return 0;
+        }
+        return drain_buffer();
+    }
 
-    char buffer[READ_BATCH_SIZE];
-    int num_read;
+    tick_count++;
+    printf("Read timer triggered %d times\n", tick_count);
     
-    // Acquire semaphore
-    semaphore_wait(semid);
+    // Acquire semaphore (semaphore mode only)
+    ring_lock(shm, semid);
     
-    // Read letters from the buffer
-    num_read = bulk_read_from_buffer(shm, buffer, READ_BATCH_SIZE);
+    // Read letters from the buffer (in record format, the keys of up to as many records)
+    if (shm->ring_format == RING_FORMAT_RECORDS) {
+        read_records_from_lanes(shm, &next_lane, &record_batch, READ_BATCH_SIZE);
+        num_read = record_keys(&record_batch, buffer);
+        record_latencies(&record_batch);
+    } else if (shm->ring_format == RING_FORMAT_PACKED) {
+        // As many whole words as unpack into the batch
+        tick_letter_count = 0;
+        consume_packed_from_lanes(shm, &next_lane, READ_BATCH_SIZE / PACKED_PER_WORD, unpack_tick_words);
+        num_read = tick_letter_count;
+        memcpy(buffer, tick_letters, (size_t)num_read * sizeof(symbol_t));
+    } else {
+        num_read = bulk_read_from_lanes(shm, &next_lane, buffer, READ_BATCH_SIZE);
+    }
     
-    // Release semaphore
-    semaphore_signal(semid);
+    // Release semaphore (semaphore mode only)
+    ring_unlock(shm, semid);
+    consumer_stats_drain(shm, num_read);
+    checkpoint_positions(checkpoint, shm);
     
     // Update letter counts
     if (num_read > 0) {
         printf("Read %d letters from buffer.\n", num_read);
         printf("Letters read: ");
         for (int i = 0; i < num_read; i++) {
-            printf("%c ", buffer[i]);
-    
-            if (buffer[i] >= MIN_LETTER && buffer[i] <= MAX_LETTER) {
-                int index = buffer[i] - MIN_LETTER;
-                letter_counts[index]++;
-            }
+            format_symbol(label, sizeof(label), buffer[i] - MIN_LETTER);
+            printf("%s ", label);
         }
         printf("\n");
+        update_letter_counts(buffer, num_read);
+        renderer_invalidate(&renderer);  // The letter dump may have scrolled the histogram away
     }
-    
-    
-    // Update histogram timer
-    time_t current_time = time(NULL);
-    printf("Time since last histogram: %ld seconds\n", current_time - last_histogram_time);
+    return num_read;
+}
+
+/*
+ * Name    : update_letter_counts
+ * Purpose : Add a batch of letters to the histogram
+ * Input   : Letter array, number of letters
+ * Outputs : letter_counts and the current window bucket updated (letters outside A-T are ignored),
+ *           letters appended to the letter log when recording
+ * Returns : None
+ */
+void update_letter_counts(const symbol_t *letters, int count) {
+    letter_log_append(recording, letters, count);
+
+#if LETTER_RANGE > 256
+    // 16-bit domain: a batch touches few of the bins, so count straight into both histograms
+    // instead of clearing and merging LETTER_RANGE batch counters per call
+    (void)count_letters(letters, (size_t)count, letter_counts);
+    (void)count_letters(letters, (size_t)count, windows->current);
+#else
+    uint64_t batch_counts[LETTER_RANGE] = {0};
 
-    if (current_time - last_histogram_time >= 10 || cleanup_mode) {
-        printf("Displaying histogram...\n");
-        display_histogram();
-        last_histogram_time = current_time;
-        usleep(5000);
+    // Count the whole batch with the selected kernel, then fold it into the histogram
+    (void)count_letters(letters, (size_t)count, batch_counts);
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        letter_counts[i] += batch_counts[i];
     }
+    windows_add(windows, batch_counts);
+#endif
+}
 
-    
-    // If in cleanup mode and no more data to read, exit
-    if (cleanup_mode && num_read == 0) {
+/*
+ * Name    : unpack_tick_words
+ * Purpose : Packed format, alarm mode: unpack a read tick's words so they can be printed
+ * Input   : Packed words, number of words
+ * Outputs : Letters appended to tick_letters
+ * Returns : None
+ */
+void unpack_tick_words(const uint64_t *words, int count) {
+    tick_letter_count += unpack_letters(words, count, tick_letters + tick_letter_count);
+}
+
+/*
+ * Name    : update_packed_counts
+ * Purpose : Packed format: add a run of packed words to the histogram without unpacking them
+ * Input   : Packed words, number of words
+ * Outputs : letter_counts, the current window bucket and packed_letters updated (padding is not
+ *           counted), letters appended to the letter log when recording
+ * Returns : None
+ */
+void update_packed_counts(const uint64_t *words, int count) {
+    size_t fields = (size_t)count * PACKED_PER_WORD;
+
+    // The log stores letters without padding, so only a recording DC unpacks
+    if (recording != NULL) {
+        symbol_t letters[UNPACK_BATCH_WORDS * PACKED_PER_WORD];
+
+        for (int done = 0; done < count; done += UNPACK_BATCH_WORDS) {
+            int words_now = (count - done < UNPACK_BATCH_WORDS) ? count - done : UNPACK_BATCH_WORDS;
+
+            letter_log_append(recording, letters, unpack_letters(words + done, words_now, letters));
+        }
+    }
+
+#if LETTER_RANGE > 256
+    // 16-bit domain (no packed ring, see PACKED_RING_SUPPORTED): count straight into both histograms
+    (void)count_packed_letters(words, fields, windows->current);
+    packed_letters += fields - count_packed_letters(words, fields, letter_counts);
+#else
+    uint64_t batch_counts[LETTER_RANGE] = {0};
+
+    // Padding fields are outside the domain, so the kernel reports them as rejected
+    packed_letters += fields - count_packed_letters(words, fields, batch_counts);
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        letter_counts[i] += batch_counts[i];
+    }
+    windows_add(windows, batch_counts);
+#endif
+}
+
+/*
+ * Name    : record_keys
+ * Purpose : Turn the key field of a batch of records into symbols for the histogram
+ * Input   : Record batch, destination (at least batch->count symbols)
+ * Outputs : Keys written as symbols (keys outside the domain are skipped)
+ * Returns : Number of symbols written
+ */
+int record_keys(const record_batch_t *batch, symbol_t *keys) {
+    int count = 0;
+
+    for (int i = 0; i < batch->count; i++) {
+        if (batch->records[i].key < LETTER_RANGE) {
+            keys[count++] = (symbol_t)(MIN_LETTER + batch->records[i].key);
+        }
+    }
+    return count;
+}
+
+/*
+ * Name    : record_latencies
+ * Purpose : Add the enqueue-to-count latency of every record in a batch to the latency histogram
+ * Input   : Record batch (just dequeued)
+ * Outputs : latency updated
+ * Returns : None
+ */
+void record_latencies(const record_batch_t *batch) {
+    struct timespec now;
+    uint64_t now_ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    now_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    for (int i = 0; i < batch->count; i++) {
+        uint64_t stamp = batch->records[i].timestamp_ns;
+
+        latency_record(&latency, (now_ns > stamp) ? now_ns - stamp : 0);
+    }
+}
+
+/*
+ * Name    : drain_records
+ * Purpose : Record format: dequeue every record currently in the lanes, RECORD_BATCH_MAX at a time,
+ *           and count their keys
+ * Input   : None
+ * Outputs : Lanes emptied, letter_counts updated
+ * Returns : Number of records read
+ */
+int drain_records(void) {
+    static symbol_t keys[RECORD_BATCH_MAX];
+    int num_read;
+    int total = 0;
+
+    do {
+        ring_lock(shm, semid);
+        num_read = read_records_from_lanes(shm, &next_lane, &record_batch, RECORD_BATCH_MAX);
+        ring_unlock(shm, semid);
+
+        update_letter_counts(keys, record_keys(&record_batch, keys));
+        record_latencies(&record_batch);
+        total += num_read;
+        // A short batch means the lanes are empty, unless it stopped because its payload space ran out
+    } while (num_read == RECORD_BATCH_MAX || record_batch.used > RECORD_BATCH_BYTES - RECORD_MAX_PAYLOAD);
+
+    consumer_stats_drain(shm, total);
+    checkpoint_positions(checkpoint, shm);
+    return total;
+}
+
+/*
+ * Name    : drain_buffer
+ * Purpose : Read every letter currently in the lanes (round-robin) and update the histogram
+ * Input   : None
+ * Outputs : Buffer emptied, letter_counts updated
+ * Returns : Number of letters read
+ */
+int drain_buffer(void) {
+    int num_read;
+    int total = 0;
+
+    if (shm->ring_format == RING_FORMAT_RECORDS) {
+        return drain_records();
+    }
+    if (shm->ring_format == RING_FORMAT_PACKED) {
+        return drain_packed();
+    }
+
+    // Count the letters where they lie in shared memory, then release them
+    do {
+        ring_lock(shm, semid);
+        num_read = consume_from_lanes(shm, &next_lane, DRAIN_BATCH_SIZE, update_letter_counts);
+        ring_unlock(shm, semid);
+
+        total += num_read;
+    } while (num_read == DRAIN_BATCH_SIZE);
+
+    consumer_stats_drain(shm, total);
+    checkpoint_positions(checkpoint, shm);
+    return total;
+}
+
+/*
+ * Name    : drain_packed
+ * Purpose : Packed format: count every word currently in the lanes where it lies
+ * Input   : None
+ * Outputs : Lanes emptied, letter_counts updated
+ * Returns : Number of letters read
+ */
+int drain_packed(void) {
+    uint64_t before = packed_letters;
+    int num_read;
+
+    do {
+        ring_lock(shm, semid);
+        num_read = consume_packed_from_lanes(shm, &next_lane, DRAIN_BATCH_SIZE, update_packed_counts);
+        ring_unlock(shm, semid);
+    } while (num_read == DRAIN_BATCH_SIZE);
+
+    consumer_stats_drain(shm, packed_letters - before);
+    checkpoint_positions(checkpoint, shm);
+    return (int)(packed_letters - before);
+}
+
+/*
+ * Name    : start_read_pass
+ * Purpose : With consumer threads: have every thread drain its lanes, or run another pass as soon
+ *           as the current one is done
+ * Input   : None
+ * Outputs : Read pass started or queued (EVENT_PASS_DONE follows)
+ * Returns : None
+ */
+void start_read_pass(void) {
+    if (!consumer_pool_dispatch(consumers)) {
+        pass_again = 1;
+    }
+}
+
+/*
+ * Name    : merge_partials
+ * Purpose : Bring letter_counts and the current window bucket up to date with the consumer threads' partial histograms
+ * Input   : None
+ * Outputs : letter_counts and windows updated (nothing to do without consumer threads)
+ * Returns : None
+ */
+void merge_partials(void) {
+    consumer_pool_merge(consumers, letter_counts, windows);
+}
+
+/*
+ * Name    : futex_bridge
+ * Purpose : Event-mode helper thread: sleeps on the ring futex (which epoll cannot watch) and turns
+ *           every wakeup into an eventfd event, then waits for the loop to drain before sleeping again
+ * Input   : Unused thread argument
+ * Outputs : data_event_fd signalled whenever a lane reaches the wake threshold
+ * Returns : NULL
+ */
+void *futex_bridge(void *arg) {
+    struct timespec timeout = { 0, SHUTDOWN_GRACE_MS * 1000000L };
+    eventfd_t drained;
+
+    (void)arg;
+    while (!atomic_load(&bridge_stop)) {
+        if (wait_for_data(shm, &timeout)) {
+            eventfd_write(data_event_fd, 1);
+            eventfd_read(drained_event_fd, &drained);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Name    : create_interval_timer
+ * Purpose : Create a periodic CLOCK_MONOTONIC timerfd
+ * Input   : Period in milliseconds
+ * Outputs : None
+ * Returns : Timer file descriptor, or -1 on error
+ */
+int create_interval_timer(long milliseconds) {
+    struct itimerspec spec;
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+    if (fd == -1) {
+        perror("timerfd_create");
+        return -1;
+    }
+    memset(&spec, 0, sizeof(spec));
+    spec.it_interval.tv_sec = milliseconds / 1000;
+    spec.it_interval.tv_nsec = (milliseconds % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, NULL) == -1) {
+        perror("timerfd_settime");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Name    : watch_fd
+ * Purpose : Add a file descriptor to the epoll set, tagged with its event source
+ * Input   : epoll descriptor, file descriptor, EVENT_* source
+ * Outputs : None
+ * Returns : 0 on success, -1 on error
+ */
+int watch_fd(int epoll_fd, int fd, uint32_t source) {
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = source;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Name    : shutdown_drain
+ * Purpose : After SIGINT: keep draining (which also unblocks blocking producers) until every
+ *           registered producer has exited, then empty the lanes one last time
+ * Input   : None
+ * Outputs : Buffer emptied, letter_counts updated
+ * Returns : None
+ */
+void shutdown_drain(void) {
+    struct timespec timeout = { 0, SHUTDOWN_GRACE_MS * 1000000L };
+    struct timespec start;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        drain_buffer();
+        wait_for_data(shm, &timeout);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (count_active_producers(shm) > 0 && now.tv_sec - start.tv_sec < PRODUCER_EXIT_TIMEOUT);
+    while (drain_buffer() > 0) {
+    }
+}
+
+/*
+ * Name    : run_event_loop
+ * Purpose : DC main loop: one epoll set watching SIGINT (signalfd), the read and display timers
+ *           (timerfd) and, in event mode, data wakeups from the futex bridge thread (eventfd)
+ * Input   : None (SIGINT must already be blocked)
+ * Outputs : Histogram displayed every 10 seconds, final drain done after SIGINT
+ * Returns : 0 on a clean shutdown, -1 if the loop could not be set up
+ */
+int run_event_loop(void) {
+    sigset_t signals;
+    struct epoll_event events[EVENT_SOURCE_COUNT];
+    struct signalfd_siginfo siginfo;
+    uint64_t expirations;
+    pthread_t bridge_thread;
+    int bridge_started = 0;
+    int epoll_fd;
+    int signal_fd;
+    int read_timer_fd;
+    int display_timer_fd;
+    int bucket_timer_fd;
+    int snapshot_timer_fd;
+    int checkpoint_timer_fd = -1;
+    long letters_since_display = 0;
+    long wakeups_since_display = 0;
+    int bridge_waiting = 0;  // The bridge waits for drained_event_fd until the threads' pass is done
+    uint64_t pass_letters;
+    int status = 0;
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    signal_fd = signalfd(-1, &signals, SFD_CLOEXEC);
+    read_timer_fd = create_interval_timer(READ_INTERVAL * 1000L);
+    display_timer_fd = create_interval_timer(DISPLAY_INTERVAL * 1000L);
+    bucket_timer_fd = create_interval_timer(WINDOW_BUCKET_SECONDS * 1000L);
+    snapshot_timer_fd = create_interval_timer(SNAPSHOT_INTERVAL_MS);
+    if (epoll_fd == -1 || signal_fd == -1 || read_timer_fd == -1 || display_timer_fd == -1 ||
+        bucket_timer_fd == -1 || watch_fd(epoll_fd, bucket_timer_fd, EVENT_BUCKET_TIMER) == -1 ||
+        snapshot_timer_fd == -1 || watch_fd(epoll_fd, snapshot_timer_fd, EVENT_SNAPSHOT_TIMER) == -1 ||
+        watch_fd(epoll_fd, signal_fd, EVENT_SIGNAL) == -1 ||
+        watch_fd(epoll_fd, read_timer_fd, EVENT_READ_TIMER) == -1 ||
+        watch_fd(epoll_fd, display_timer_fd, EVENT_DISPLAY_TIMER) == -1) {
+        perror("DC: event loop setup");
+        status = -1;
         running = 0;
-        return;
     }
-    
-    // Set alarm for next read
-    alarm(2);
+
+    // Checkpoint flushes, only when there is a checkpoint file
+    if (status == 0 && checkpoint != NULL) {
+        checkpoint_timer_fd = create_interval_timer(checkpoint_flush_ms);
+        if (checkpoint_timer_fd == -1 || watch_fd(epoll_fd, checkpoint_timer_fd, EVENT_CHECKPOINT_TIMER) == -1) {
+            perror("DC: checkpoint timer setup");
+            status = -1;
+            running = 0;
+        }
+    }
+
+    // Event mode: a helper thread forwards futex wakeups into the epoll set
+    if (status == 0 && consumer_mode == DC_MODE_EVENT) {
+        data_event_fd = eventfd(0, EFD_CLOEXEC);
+        drained_event_fd = eventfd(0, EFD_CLOEXEC);
+        if (data_event_fd == -1 || drained_event_fd == -1 ||
+            watch_fd(epoll_fd, data_event_fd, EVENT_DATA) == -1 ||
+            pthread_create(&bridge_thread, NULL, futex_bridge, NULL) != 0) {
+            perror("DC: futex bridge setup");
+            status = -1;
+            running = 0;
+        } else {
+            bridge_started = 1;
+        }
+    }
+
+    // Consumer threads: the loop starts their read passes and hears back on their eventfd
+    if (status == 0 && consumer_threads > 1) {
+        if (consumer_pool_start(&consumer_pool, shm, semid, consumer_threads) != 0) {
+            status = -1;
+            running = 0;
+        } else {
+            consumers = &consumer_pool;
+            if (watch_fd(epoll_fd, consumer_pool.done_fd, EVENT_PASS_DONE) == -1) {
+                status = -1;
+                running = 0;
+            }
+        }
+    }
+
+    while (running && !cleanup_mode) {
+        int ready = epoll_wait(epoll_fd, events, EVENT_SOURCE_COUNT, -1);
+
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            switch (events[i].data.u32) {
+            case EVENT_SIGNAL:
+                // Ctrl+C: stop every registered producer, then leave the loop for the final drain
+                if (read(signal_fd, &siginfo, sizeof(siginfo)) == (ssize_t)sizeof(siginfo)) {
+                    cleanup_mode = 1;
+                    signal_producers(shm, SIGINT);
+                }
+                break;
+            case EVENT_DATA:
+                // A lane crossed the wake threshold: drain, then let the bridge sleep again
+                eventfd_read(data_event_fd, &expirations);
+                wakeups_since_display++;
+                wakeups_total++;
+                consumer_stats_wakeup(shm);
+                if (consumers != NULL) {
+                    start_read_pass();  // The bridge sleeps again once the pass is done
+                    bridge_waiting = 1;
+                    break;
+                }
+                letters_since_display += drain_buffer();
+                eventfd_write(drained_event_fd, 1);
+                break;
+            case EVENT_PASS_DONE:
+                // Every consumer thread has drained its lanes
+                pass_letters = consumer_pool_pass_done(consumers);
+                letters_since_display += (long)pass_letters;
+                consumer_stats_drain(shm, (int)pass_letters);
+                if (checkpoint != NULL) {
+                    // The lanes are released: the checkpoint must hold these letters before it moves on
+                    merge_partials();
+                }
+                checkpoint_positions(checkpoint, shm);
+                if (bridge_waiting) {
+                    bridge_waiting = 0;
+                    eventfd_write(drained_event_fd, 1);
+                }
+                if (pass_again) {
+                    pass_again = 0;
+                    start_read_pass();
+                }
+                break;
+            case EVENT_READ_TIMER:
+                if (read(read_timer_fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                    letters_since_display += read_tick();
+                }
+                break;
+            case EVENT_BUCKET_TIMER:
+                // Close one bucket per elapsed second; missed seconds become empty buckets
+                if (read(bucket_timer_fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                    merge_partials();  // The threads' letters belong in the bucket being closed
+                    for (uint64_t tick = 0; tick < expirations && tick <= WINDOW_BUCKETS; tick++) {
+                        windows_rotate(windows);
+                    }
+                    checkpoint_bucket_closed(checkpoint);
+                }
+                break;
+            case EVENT_SNAPSHOT_TIMER:
+                if (read(snapshot_timer_fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                    publish_dc_snapshot(1);
+                }
+                break;
+            case EVENT_CHECKPOINT_TIMER:
+                if (read(checkpoint_timer_fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                    merge_partials();
+                    checkpoint_flush(checkpoint);
+                }
+                break;
+            case EVENT_DISPLAY_TIMER:
+                if (read(display_timer_fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                    display_histogram();
+                    printf("Read %ld letters in %ld wakeups since last histogram\n",
+                           letters_since_display, wakeups_since_display);
+                    letters_since_display = 0;
+                    wakeups_since_display = 0;
+                }
+                break;
+            }
+        }
+    }
+
+    // Stop the bridge and the consumer threads before draining, so only this thread touches the
+    // ring from here on
+    if (bridge_started) {
+        atomic_store(&bridge_stop, 1);
+        eventfd_write(drained_event_fd, 1);
+        futex_wake(&shm->data_futex);
+        pthread_join(bridge_thread, NULL);
+    }
+    if (consumers != NULL) {
+        consumer_pool_stop(consumers, letter_counts, windows);
+        consumers = NULL;
+    }
+    if (cleanup_mode) {
+        shutdown_drain();
+    }
+    running = 0;
+
+    // Close every descriptor that was opened
+    int fds[] = { epoll_fd, signal_fd, read_timer_fd, display_timer_fd, bucket_timer_fd, snapshot_timer_fd,
+                  checkpoint_timer_fd, data_event_fd, drained_event_fd };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (fds[i] != -1) {
+            close(fds[i]);
+        }
+    }
+    return status;
 }
 
 /*
  * Name    : display_histogram
- * Purpose : Displays the histogram based on letter_counts[]
+ * Purpose : Displays the histogram based on letter_counts[] with the frame renderer
  * Input   : None
  * Outputs : Printed histogram on terminal
  * Returns : None
  */
 void display_histogram() {
-    // Clear screen
-    printf("\033[2J\033[H");
+    merge_partials();
+
+    // One write for the whole frame, only the rows that changed when stdout is a terminal
+    render_histogram(&renderer, letter_counts);
+
+    display_window_stats();
+    display_latency_stats();
+    display_producer_stats();
     
-    // Display histogram for each letter
-    for (int i = 0; i < LETTER_RANGE; i++) {
-        char letter = MIN_LETTER + i;
-        int count = letter_counts[i];
-        
-        // Display letter and count
-        printf("%c-%03d ", letter, count);
-        
-        // Display histogram bars
-        int hundreds = count / 100;
-        int tens = (count % 100) / 10;
-        int ones = count % 10;
-        
-        // Display hundreds as '*' 
-        for (int h = 0; h < hundreds; h++) {
-            printf("*");
+    fflush(stdout);
+}
+
+/*
+ * Name    : display_window_stats
+ * Purpose : Displays the rolling 10s / 1m / 5m windows: letters, total rate and per-letter rates (when LETTER_RANGE fits, see WINDOW_LETTER_COLUMNS)
+ * Input   : None
+ * Outputs : Printed window table on terminal
+ * Returns : None
+ */
+void display_window_stats(void) {
+    char label[16];
+
+    printf("\n%-6s %12s %10s", "Window", "Letters", "Rate/s");
+    if (WINDOW_LETTER_COLUMNS) {
+        printf("  Letters/s");
+        for (int i = 0; i < LETTER_RANGE; i++) {
+            format_symbol(label, sizeof(label), i);
+            printf(" %7s", label);
         }
-        
-        // Display tens as '+'
-        for (int t = 0; t < tens; t++) {
-            printf("+");
+    }
+    printf("\n");
+
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        printf("%-6s %12llu %10.1f", window_name(w), (unsigned long long)window_total(windows, w),
+               window_rate(windows, w, -1));
+        if (WINDOW_LETTER_COLUMNS) {
+            printf("           ");
         }
-        
-        // Display ones as '-'
-        for (int o = 0; o < ones; o++) {
-            printf("-");
+        for (int i = 0; WINDOW_LETTER_COLUMNS && i < LETTER_RANGE; i++) {
+            printf(" %7.1f", window_rate(windows, w, i));
         }
-        
         printf("\n");
     }
-    
-    fflush(stdout);
+}
+
+/*
+ * Name    : display_latency_stats
+ * Purpose : Displays enqueue-to-count latency percentiles (record format only, the only one with timestamps)
+ * Input   : None
+ * Outputs : Printed latency line on terminal
+ * Returns : None
+ */
+void display_latency_stats(void) {
+    if (shm->ring_format != RING_FORMAT_RECORDS) {
+        return;
+    }
+    printf("\nLatency (enqueue to count, %llu records, us): p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f  mean %.1f\n",
+           (unsigned long long)latency.total, latency_percentile(&latency, 50.0) / 1000.0,
+           latency_percentile(&latency, 99.0) / 1000.0, latency_percentile(&latency, 99.9) / 1000.0,
+           latency.max / 1000.0, latency_mean(&latency) / 1000.0);
+}
+
+/*
+ * Name    : display_producer_stats
+ * Purpose : Displays each producer's overflow policy, target and achieved rate and counters from shared memory
+ * Input   : None
+ * Outputs : Printed producer table on terminal
+ * Returns : None
+ */
+void display_producer_stats(void) {
+    printf("\n%-5s %-8s %-7s %-10s %6s %10s %11s %12s %12s %12s %12s\n", "Lane", "PID", "State", "Policy",
+           "Batch", "Target/s", "Achieved/s", "Written", "Dropped", "Overwritten", "Blocked(ms)");
+
+    for (int i = 0; i < MAX_PRODUCERS; i++) {
+        producer_slot_t *producer = &shm->producers[i];
+        int state = atomic_load(&producer->state);
+
+        if (state == SLOT_FREE) {
+            continue;  // Slot not in use
+        }
+        printf("%-5d %-8d %-7s %-10s %6d %10.1f %11.1f %12llu %12llu %12llu %12llu\n", i, (int)producer->pid,
+               (state == SLOT_ACTIVE) ? "active" : "exited", overflow_policy_name(producer->policy),
+               producer->batch_size, producer->rate, producer_achieved_rate(producer),
+               (unsigned long long)atomic_load_explicit(&producer->written, memory_order_relaxed),
+               (unsigned long long)atomic_load_explicit(&producer->dropped, memory_order_relaxed),
+               (unsigned long long)atomic_load_explicit(&producer->overwritten, memory_order_relaxed),
+               (unsigned long long)(atomic_load_explicit(&producer->blocked_ns, memory_order_relaxed) / 1000000ULL));
+    }
+}
+
+/*
+ * Name    : publish_dc_snapshot
+ * Purpose : Publish counts, rolling windows and ring statistics to the snapshot region
+ * Input   : 1 while DC is running, 0 for the final snapshot
+ * Outputs : Snapshot region updated (nothing happens if the region could not be created)
+ * Returns : None
+ */
+void publish_dc_snapshot(int dc_running) {
+    static uint64_t publish_count = 0;
+    static histogram_snapshot_t snapshot;  // Static: with a wide symbol domain it is too big for the stack
+    struct timespec now;
+
+    merge_partials();
+    if (snapshot_region == NULL) {
+        return;
+    }
+
+    memset(&snapshot, 0, sizeof(snapshot));
+    clock_gettime(CLOCK_REALTIME, &now);
+    snapshot.publish_count = ++publish_count;
+    snapshot.timestamp_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    snapshot.dc_pid = getpid();
+    snapshot.dc_running = dc_running;
+    memcpy(snapshot.counts, letter_counts, sizeof(snapshot.counts));
+    memcpy(snapshot.window_counts, windows->sums, sizeof(snapshot.window_counts));
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        snapshot.window_seconds[w] = window_seconds(windows, w);
+    }
+    snapshot.wakeups = wakeups_total;
+    snapshot.latency_count = latency.total;
+    snapshot.latency_p50_ns = latency_percentile(&latency, 50.0);
+    snapshot.latency_p99_ns = latency_percentile(&latency, 99.0);
+    snapshot.latency_p999_ns = latency_percentile(&latency, 99.9);
+    snapshot.latency_max_ns = latency.max;
+
+    // Ring statistics straight from the main segment
+    snapshot.capacity = lane_capacity(shm);
+    snapshot.ring_format = shm->ring_format;
+    snapshot.lane_count = (int)shm->header.lane_count;
+    snapshot.active_producers = count_active_producers(shm);
+    for (int lane = 0; lane < snapshot.lane_count; lane++) {
+        producer_slot_t *producer = &shm->producers[lane];
+
+        snapshot.lane_used[lane] = (uint64_t)get_used_space(shm, lane);
+        snapshot.written += atomic_load_explicit(&producer->written, memory_order_relaxed);
+        snapshot.dropped += atomic_load_explicit(&producer->dropped, memory_order_relaxed);
+        snapshot.overwritten += atomic_load_explicit(&producer->overwritten, memory_order_relaxed);
+    }
+
+    publish_snapshot(snapshot_region, &snapshot);
 }
 
 /*
@@ -189,33 +868,130 @@ void cleanup_and_exit() {
     
     fflush(stdout);
 
+    // Last snapshot for any viewer still attached, then let the segment go with its last reader
+    publish_dc_snapshot(0);
+    if (snapshot_region != NULL) {
+        detach_snapshot_region(snapshot_region);
+        remove_snapshot_region(snapshot_shmid);
+    }
+
+    // Seal the checkpoint so the next DC resumes from here
+    close_checkpoint(checkpoint);
+    if (recording != NULL) {
+        letter_log_close(recording);
+        printf("DC: Recorded %llu letters in %llu bytes\n", (unsigned long long)recording->letters,
+               (unsigned long long)recording->bytes);
+    }
+
     // Clean up IPC resources if we're the last to use them 
+    consumer_stats_detach(shm);
     detach_shared_memory(shm);
+    renderer_free(&renderer);
 }
 
 /*
  * Name    : main
  * Purpose : Entry point for DC process
- * Input   : Command-line arguments <shmid> <dp1_pid> <dp2_pid>
- * Outputs : Attaches to IPC, sets alarms, loops until SIGINT
+ * Input   : Command-line arguments [-m event|alarm] [-t wake_threshold] [-k auto|scalar|sse2|avx2]
+ *           [-b classic|log|auto] [-c checkpoint_file] [-f flush_ms] [-w letter_log] [-T threads] <shmid>
+ *           (-m, -t, -k, -b, -c, -f, -w and -T default to $HISTO_DC_MODE, $HISTO_WAKE_THRESHOLD,
+ *           $HISTO_COUNT_KERNEL, $HISTO_BAR_MODE, $HISTO_CHECKPOINT, $HISTO_CHECKPOINT_MS,
+ *           $HISTO_LETTER_LOG and $HISTO_DC_THREADS)
+ * Outputs : Attaches to IPC, consumes letters until SIGINT
  * Returns : EXIT_SUCCESS or EXIT_FAILURE
  */
 int main(int argc, char *argv[]) {
+    const char *mode_name = getenv("HISTO_DC_MODE");
+    const char *threshold_text = getenv("HISTO_WAKE_THRESHOLD");
+    const char *kernel_name = getenv("HISTO_COUNT_KERNEL");
+    const char *bar_mode_name = getenv("HISTO_BAR_MODE");
+    const char *checkpoint_path = getenv("HISTO_CHECKPOINT");
+    const char *flush_text = getenv("HISTO_CHECKPOINT_MS");
+    const char *log_path = getenv("HISTO_LETTER_LOG");
+    const char *threads_text = getenv("HISTO_DC_THREADS");
+    static uint64_t memory_counts[LETTER_RANGE];  // Used when there is no checkpoint
+    static window_set_t memory_windows;
+    int bar_mode = BAR_MODE_CLASSIC;
+    long wake_threshold = 1;
+    int opt;
+
     setvbuf(stdout, NULL, _IONBF, 0);
 
+    // Parse options
+    while ((opt = getopt(argc, argv, "m:t:k:b:c:f:w:T:")) != -1) {
+        switch (opt) {
+        case 'm':
+            mode_name = optarg;
+            break;
+        case 't':
+            threshold_text = optarg;
+            break;
+        case 'k':
+            kernel_name = optarg;
+            break;
+        case 'b':
+            bar_mode_name = optarg;
+            break;
+        case 'c':
+            checkpoint_path = optarg;
+            break;
+        case 'f':
+            flush_text = optarg;
+            break;
+        case 'w':
+            log_path = optarg;
+            break;
+        case 'T':
+            threads_text = optarg;
+            break;
+        default:
+            argc = 0;  // Force the usage message below
+            break;
+        }
+    }
+
     // Check arguments 
-    if (argc != 4) {
-        fprintf(stderr, "Usage: %s <shmid> <dp1_pid> <dp2_pid>\n", argv[0]);
+    if (argc - optind != 1) {
+        fprintf(stderr, "Usage: %s [-m event|alarm] [-t wake_threshold] [-k auto|scalar|sse2|avx2] "
+                        "[-b classic|log|auto] [-c checkpoint_file] [-f flush_ms] [-w letter_log] [-T threads] <shmid>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (mode_name != NULL) {
+        if (strcmp(mode_name, "alarm") == 0) {
+            consumer_mode = DC_MODE_ALARM;
+        } else if (strcmp(mode_name, "event") != 0) {
+            fprintf(stderr, "Unknown consumer mode '%s'\n", mode_name);
+            return EXIT_FAILURE;
+        }
+    }
+    if (threshold_text != NULL) {
+        wake_threshold = atol(threshold_text);
+    }
+    if (flush_text != NULL) {
+        checkpoint_flush_ms = atol(flush_text);
+    }
+    if (threads_text != NULL) {
+        consumer_threads = atoi(threads_text);
+    }
+    if (bar_mode_name != NULL && (bar_mode = parse_bar_mode(bar_mode_name)) == -1) {
+        fprintf(stderr, "Unknown bar mode '%s'\n", bar_mode_name);
+        return EXIT_FAILURE;
+    }
+    if (renderer_init(&renderer, STDOUT_FILENO, bar_mode, RENDER_DEFAULT_WIDTH) != 0) {
+        fprintf(stderr, "Failed to set up the histogram renderer\n");
+        return EXIT_FAILURE;
+    }
+    if (select_count_kernel(kernel_name) != 0) {
+        fprintf(stderr, "Counting kernel '%s' is unknown or not supported by this CPU\n", kernel_name);
         return EXIT_FAILURE;
     }
     
     // Get command line arguments 
-    shmid = atoi(argv[1]);
-    dp1_pid = atoi(argv[2]);
-    dp2_pid = atoi(argv[3]);
+    shmid = atoi(argv[optind]);
     
     // Verify arguments 
-    if (shmid <= 0 || dp1_pid <= 0 || dp2_pid <= 0) {
+    if (shmid < 0 || wake_threshold <= 0 || checkpoint_flush_ms <= 0 || consumer_threads < 1 ||
+        consumer_threads > DC_MAX_THREADS) {
         fprintf(stderr, "Invalid arguments\n");
         return EXIT_FAILURE;
     }
@@ -234,37 +1010,78 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
-    last_histogram_time = time(NULL);
-    
-    // Set up signal handlers
-      struct sigaction sa;
-
-      // SIGALRM
-      // Configure SIGALRM using sigaction for reliable signal handling
-      // SA_RESTART ensures interrupted syscalls resume automatically
-      memset(&sa, 0, sizeof(sa));
-      sa.sa_handler = sigalrm_handler;
-      sa.sa_flags = SA_RESTART;
-      sigemptyset(&sa.sa_mask);
-      if (sigaction(SIGALRM, &sa, NULL) == -1) {
-          perror("sigaction(SIGALRM)");
-          return EXIT_FAILURE;
-      }
-  
-      // SIGINT
-      if (signal(SIGINT, sigint_handler) == SIG_ERR) {
-          perror("signal(SIGINT)");
-          return EXIT_FAILURE;
-      }
-  
-    
-    // Start the 2-second alarm for reading data
-    alarm(2);
-    printf("DC: Setup complete, waiting for alarms...\n");
-    
-    // Main loop */
-    while (running) {
-        pause();  // Wait for signals
+    // A threshold larger than the ring could never be reached (record format counts bytes, packed
+    // format words)
+    if (shm->ring_format == RING_FORMAT_PACKED) {
+        wake_threshold = (wake_threshold + PACKED_PER_WORD - 1) / PACKED_PER_WORD;
+    }
+    if ((uint64_t)wake_threshold > lane_capacity(shm)) {
+        wake_threshold = (long)lane_capacity(shm);
+    }
+    shm->wake_threshold = (uint64_t)wake_threshold;
+
+    // Consumer threads split the lanes in event mode; records (latency histogram) and the letter
+    // log (one ordered stream) need the single reader
+    if (consumer_threads > 1 && (consumer_mode != DC_MODE_EVENT || shm->ring_format == RING_FORMAT_RECORDS ||
+                                 log_path != NULL)) {
+        fprintf(stderr, "DC: -T needs event mode, symbol or packed format and no -w\n");
+        detach_shared_memory(shm);
+        return EXIT_FAILURE;
+    }
+    if (consumer_threads > (int)shm->header.lane_count) {
+        consumer_threads = (int)shm->header.lane_count;  // A thread without lanes would have nothing to do
+    }
+    consumer_stats_attach(shm);
+
+    // Counts and windows: in the checkpoint file if there is one, otherwise in our own memory
+    if (checkpoint_path != NULL && (checkpoint = open_checkpoint(checkpoint_path, shm, shmid)) == NULL) {
+        detach_shared_memory(shm);
+        return EXIT_FAILURE;
+    }
+    if (log_path != NULL) {
+        if (letter_log_create(&letter_log, log_path) != 0) {
+            close_checkpoint(checkpoint);
+            detach_shared_memory(shm);
+            return EXIT_FAILURE;
+        }
+        recording = &letter_log;
+    }
+    if (checkpoint != NULL) {
+        letter_counts = checkpoint->letter_counts;
+        windows = &checkpoint->windows;
+    } else {
+        letter_counts = memory_counts;
+        windows = &memory_windows;
+        windows_init(windows);
+    }
+
+    // Snapshot region for monitoring tools; DC works the same without it
+    snapshot_shmid = create_snapshot_region(&snapshot_region);
+    if (snapshot_shmid == -1) {
+        snapshot_region = NULL;
+        fprintf(stderr, "DC: Snapshot region unavailable, continuing without it\n");
+    }
+
+    // SIGINT is read from a signalfd by the event loop, so block its normal delivery
+    // (before any thread is started, so the futex bridge inherits the mask)
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    if (sigprocmask(SIG_BLOCK, &signals, NULL) == -1) {
+        perror("sigprocmask");
+        detach_shared_memory(shm);
+        return EXIT_FAILURE;
+    }
+
+    if (consumer_mode == DC_MODE_EVENT) {
+        printf("DC: Setup complete, event mode (wake threshold %ld, %s counting, %d consumer thread%s)...\n",
+               wake_threshold, count_kernel_name(), consumer_threads, (consumer_threads == 1) ? "" : "s");
+    } else {
+        printf("DC: Setup complete, reading %d letters every %d seconds...\n", READ_BATCH_SIZE, READ_INTERVAL);
+    }
+    if (run_event_loop() != 0) {
+        detach_shared_memory(shm);
+        return EXIT_FAILURE;
     }
     
     // Clean up and exit
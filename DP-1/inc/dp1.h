@@ -15,18 +15,38 @@
 #ifndef DP1_H
 #define DP1_H
 
+#include "../../common/inc/common.h"
 #include <signal.h>
+#include <sys/types.h>
 #define SEM_KEY 0x1234
 
+// Classic DP-1 output: 20 letters every 2 seconds
+#define DP1_BATCH_SIZE 20
+#define DP1_RATE 10.0  // Letters per second
+
+// One producer of a fleet, parsed from "[count*]batch@rate"
+typedef struct {
+    int batch_size;  // Letters per write
+    double rate;     // Target letters per second
+} producer_spec_t;
+
 //Signal handler for SIGINT
 void sigint_handler(int signum);
 
-//Function to generate and write 20 random letters
-void generate_and_write_letters();
+//Function to generate and write a batch of random letters
+void generate_and_write_letters(int count);
+
+//Fleet mode helpers
+int parse_fleet_spec(const char *text, producer_spec_t *specs, int max_specs);
+pid_t launch_process(const char *path, char *const argv[]);
+int run_fleet(const producer_spec_t *specs, int count);
+int run_replay(const char *log_path, int fast);
 
 //Global variables
 extern int running; // Controls DP-1 loop, modified by SIGINT handler
 extern int shmid;   // Stores shared memory ID for setup and cleanup
 extern int semid; // Stores semaphore ID used to synchronize writes
+extern int producer_slot; // Registry slot (and lane) DP-1 writes to in classic mode
+extern int record_payload; // Largest record payload in record format ($HISTO_RECORD_PAYLOAD)
 
 #endif
\ No newline at end of file
@@ -7,20 +7,37 @@
  * This file contains the main logic for DP-1 (Data Producer 1). It is responsible for creating and initializing
  * shared memory and semaphores. DP-1 generates 20 random letters every 2 seconds and writes them to the shared
  * circular buffer. It also forks and launches the DP-2 process and handles cleanup on SIGINT.
+ * Writes are paced against absolute deadlines (pacer.h); -r or HISTO_DP1_RATE changes the rate.
+ * Setting HISTO_SEED makes every producer's letter sequence repeatable.
+ * In fleet mode (-F) DP-1 does not produce itself: it launches one DP-2 per producer spec, each with its
+ * own batch size and rate, then launches DC and waits for all of them. Every producer registers itself in
+ * the shared-memory producer registry, which is how DC finds and stops them.
+ * The ring synchronization mode (lock-free or semaphore) is chosen here with -m or HISTO_RING_MODE,
+ * and the ring capacity with -s or HISTO_RING_SIZE. -R records (or HISTO_RING_FORMAT) makes the lanes
+ * carry framed event records instead of raw letters: each letter becomes a record keyed by the letter,
+ * timestamped when it was generated, with a payload of up to HISTO_RECORD_PAYLOAD bytes. -R packed
+ * (A-T build only) packs 12 five-bit letters into every 64-bit word of a lane.
+ * In replay mode (-P or HISTO_REPLAY) DP-1 creates a single-lane ring and launches a replay producer
+ * (DP-2 -P) that feeds a recorded letter log into it at the recorded timing, or at maximum speed with -x.
  */
+#define _POSIX_C_SOURCE 200809L  // Enables POSIX-compliant features like getopt
 
 #include "../inc/dp1.h"
 
 #include "../../common/inc/shared_memory.h"
 #include "../../common/inc/semaphore_utils.h"
 #include "../../common/inc/circular_buffer.h"
+#include "../../common/inc/producer_registry.h"
+#include "../../common/inc/pacer.h"
 #include "../../common/inc/common.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <limits.h>
+#include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include <sys/wait.h>
 
 #define PATH_MAX 4096
@@ -30,6 +47,8 @@ int running = 1;
 int shmid = -1;
 int semid = -1;
 shared_memory_t *shm = NULL;
+int producer_slot = -1;
+int record_payload = 0;
 
 /*
  * Name    : sigint_handler
@@ -44,46 +63,299 @@ void sigint_handler(int signum) {
 
 /*
  * Name    : generate_and_write_letters
- * Purpose : Generates and writes 20 random letters to shared memory
- * Input   : None
+ * Purpose : Generates and writes a batch of random letters (20 at the default rate) to shared memory
+ * Input   : Number of letters the pacer released
  * Outputs : Writes to the circular buffer in shared memory
  * Returns : None
  */
-void generate_and_write_letters() {
-    char letters[20];
-    
-    // Generate 20 random letters
-    for (int i = 0; i < 20; i++) {
-        letters[i] = generate_random_letter();
+void generate_and_write_letters(int count) {
+    static symbol_t *letters = NULL;
+    static int capacity = 0;
+
+    // Symbol format: generate the letters straight into our lane, applying our overflow policy
+    // (takes the semaphore in semaphore mode)
+    if (shm->ring_format != RING_FORMAT_RECORDS) {
+        (void)write_in_place(shm, semid, producer_slot, generate_random_letters, count); //(void) silences unused warnings
+        return;
+    }
+
+    // Record format: grow the batch buffer if the pacer hands out more letters than before
+    if (count > capacity) {
+        symbol_t *grown = realloc(letters, (size_t)count * sizeof(symbol_t));
+
+        if (grown == NULL) {
+            perror("DP-1: realloc");
+            return;
+        }
+        letters = grown;
+        capacity = count;
     }
     
-    // Acquire semaphore
-    semaphore_wait(semid);
-    
-    // Write letters to buffer
-    (void)bulk_write_to_buffer(shm, letters, 20); //(void) silences unused warnings
-    
-    // Release semaphore 
-    semaphore_signal(semid);
+    // Generate the random letters and send one record per letter
+    generate_random_letters(letters, count);
+    (void)write_letters_as_records(shm, semid, producer_slot, letters, count, record_payload);
+}
+
+/*
+ * Name    : parse_fleet_spec
+ * Purpose : Parse a fleet description such as "20@10,1@20,4*100@5000" (batch@letters-per-second,
+ *           optionally repeated count times)
+ * Input   : Spec text, output array, array size
+ * Outputs : specs filled in
+ * Returns : Number of producers, or -1 if the text is invalid or names too many producers
+ */
+int parse_fleet_spec(const char *text, producer_spec_t *specs, int max_specs) {
+    int count = 0;
+    const char *p = text;
+
+    while (*p != '\0') {
+        char *end;
+        long repeat = 1;
+        long batch = strtol(p, &end, 10);
+        double rate;
+
+        if (*end == '*') {
+            repeat = batch;
+            p = end + 1;
+            batch = strtol(p, &end, 10);
+        }
+        if (end == p || *end != '@' || batch <= 0 || repeat <= 0) {
+            return -1;
+        }
+        p = end + 1;
+        rate = strtod(p, &end);
+        if (end == p || rate <= 0 || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        p = (*end == ',') ? end + 1 : end;
+
+        for (long i = 0; i < repeat; i++) {
+            if (count == max_specs) {
+                return -1;
+            }
+            specs[count].batch_size = (int)batch;
+            specs[count].rate = rate;
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * Name    : launch_process
+ * Purpose : Fork and exec one of the system's binaries
+ * Input   : Path to the binary, argument vector (NULL terminated)
+ * Outputs : Child process started
+ * Returns : Child PID, or -1 if fork failed
+ */
+pid_t launch_process(const char *path, char *const argv[]) {
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        perror("fork");
+    } else if (pid == 0) {
+        execv(path, argv);
+        // If exec fails
+        perror("execv");
+        exit(EXIT_FAILURE);
+    }
+    return pid;
+}
+
+/*
+ * Name    : run_fleet
+ * Purpose : Launch one DP-2 per producer spec and then DC, and wait for all of them to exit
+ * Input   : Producer specs, number of producers
+ * Outputs : Fleet processes started and reaped
+ * Returns : EXIT_SUCCESS, or EXIT_FAILURE if a process could not be launched
+ */
+int run_fleet(const producer_spec_t *specs, int count) {
+    char path[PATH_MAX];
+    char shmid_str[16];
+    char batch_str[16];
+    char rate_str[32];
+    int status = EXIT_SUCCESS;
+
+    snprintf(shmid_str, sizeof(shmid_str), "%d", shmid);
+
+    // Producers first, each with its own batch size and rate
+    snprintf(path, sizeof(path), "%s/DP-2/bin/DP-2", getenv("PWD"));
+    for (int i = 0; i < count; i++) {
+        char *argv[] = { "DP-2", "-f", "-b", batch_str, "-r", rate_str, shmid_str, NULL };
+
+        snprintf(batch_str, sizeof(batch_str), "%d", specs[i].batch_size);
+        snprintf(rate_str, sizeof(rate_str), "%g", specs[i].rate);
+        if (launch_process(path, argv) < 0) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    // Then the consumer, which finds the producers through the registry
+    snprintf(path, sizeof(path), "%s/DC/bin/DC", getenv("PWD"));
+    {
+        char *argv[] = { "DC", shmid_str, NULL };
+
+        if (launch_process(path, argv) < 0) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    // DC stops the producers on SIGINT; wait for every child to finish
+    while (wait(NULL) > 0) {
+    }
+    return status;
+}
+
+/*
+ * Name    : run_replay
+ * Purpose : Launch a replay producer for a letter log and then DC, and wait for both to exit
+ * Input   : Letter log path, fast flag (1 = maximum speed)
+ * Outputs : Replay producer and DC started and reaped
+ * Returns : EXIT_SUCCESS, or EXIT_FAILURE if a process could not be launched
+ */
+int run_replay(const char *log_path, int fast) {
+    char path[PATH_MAX];
+    char shmid_str[16];
+    char *producer_argv[] = { "DP-2", "-f", "-p", "block", "-P", (char *)log_path, shmid_str, NULL, NULL };
+    char *dc_argv[] = { "DC", shmid_str, NULL };
+    int status = EXIT_SUCCESS;
+
+    snprintf(shmid_str, sizeof(shmid_str), "%d", shmid);
+
+    // A replay must not lose letters, so the producer blocks when the ring is full
+    if (fast) {
+        producer_argv[6] = "-x";
+        producer_argv[7] = shmid_str;
+    }
+    snprintf(path, sizeof(path), "%s/DP-2/bin/DP-2", getenv("PWD"));
+    if (launch_process(path, producer_argv) < 0) {
+        status = EXIT_FAILURE;
+    }
+    snprintf(path, sizeof(path), "%s/DC/bin/DC", getenv("PWD"));
+    if (launch_process(path, dc_argv) < 0) {
+        status = EXIT_FAILURE;
+    }
+
+    // The producer exits at the end of the log, DC on SIGINT
+    while (wait(NULL) > 0) {
+    }
+    return status;
 }
 
 /*
  * Name    : main
  * Purpose : Entry point of DP-1, sets up IPC, launches DP-2, and loops writing letters
- * Input   : None
+ * Input   : Optional -m <lockfree|semaphore> (defaults to $HISTO_RING_MODE, then lockfree)
+ *           Optional -s <size>[K|M|G] ring capacity (defaults to $HISTO_RING_SIZE, then 64K)
+ *           Optional -p <drop|block|overwrite> overflow policy (defaults to $HISTO_DP1_POLICY, then drop)
+ *           Optional -r <letters per second> classic DP-1 rate (defaults to $HISTO_DP1_RATE, then 10)
+ *           Optional -F <[count*]batch@rate,...> fleet mode (defaults to $HISTO_FLEET)
+ *           Optional -R <symbols|records|packed> ring format (defaults to $HISTO_RING_FORMAT, then symbols)
+ *           Optional -P <letter_log> replay mode (defaults to $HISTO_REPLAY), -x replays at maximum speed
  * Outputs : Launches DP-2 and writes to shared memory
  * Returns : EXIT_SUCCESS on clean exit, EXIT_FAILURE on error
  */
-int main() {
+int main(int argc, char *argv[]) {
     pid_t dp2_pid;
     char shmid_str[16];
     char path[PATH_MAX];
+    const char *mode_name = getenv("HISTO_RING_MODE");
+    const char *size_text = getenv("HISTO_RING_SIZE");
+    const char *policy_name = getenv("HISTO_DP1_POLICY");
+    int policy = OVERFLOW_DROP_NEWEST;
+    double rate = (getenv("HISTO_DP1_RATE") != NULL) ? atof(getenv("HISTO_DP1_RATE")) : DP1_RATE;
+    pacer_t pacer;
+    int count;
+    const char *fleet_text = getenv("HISTO_FLEET");
+    const char *replay_path = getenv("HISTO_REPLAY");
+    int replay_fast = 0;
+    producer_spec_t fleet[MAX_PRODUCERS];
+    int fleet_size = 0;
+    int lane_count = DEFAULT_LANE_COUNT;
+    int ring_mode = RING_MODE_LOCKFREE;
+    const char *format_name = getenv("HISTO_RING_FORMAT");
+    int ring_format = RING_FORMAT_SYMBOLS;
+    uint64_t capacity = DEFAULT_BUFFER_SIZE;
+    int opt;
+
+    // Parse options
+    while ((opt = getopt(argc, argv, "m:s:p:r:F:R:P:x")) != -1) {
+        switch (opt) {
+        case 'm':
+            mode_name = optarg;
+            break;
+        case 's':
+            size_text = optarg;
+            break;
+        case 'p':
+            policy_name = optarg;
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 'F':
+            fleet_text = optarg;
+            break;
+        case 'R':
+            format_name = optarg;
+            break;
+        case 'P':
+            replay_path = optarg;
+            break;
+        case 'x':
+            replay_fast = 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-m lockfree|semaphore] [-s size[K|M|G]] [-p drop|block|overwrite] "
+                            "[-r rate] [-F [count*]batch@rate,...] [-R symbols|records|packed] [-P letter_log [-x]]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (mode_name != NULL) {
+        ring_mode = parse_ring_mode(mode_name);
+        if (ring_mode == -1) {
+            fprintf(stderr, "DP-1: Unknown ring mode '%s'\n", mode_name);
+            return EXIT_FAILURE;
+        }
+    }
+    if (size_text != NULL && parse_buffer_size(size_text, &capacity) == -1) {
+        fprintf(stderr, "DP-1: Invalid ring size '%s' (1K to 16G)\n", size_text);
+        return EXIT_FAILURE;
+    }
+    if (policy_name != NULL && (policy = parse_overflow_policy(policy_name)) == -1) {
+        fprintf(stderr, "DP-1: Unknown overflow policy '%s'\n", policy_name);
+        return EXIT_FAILURE;
+    }
+    if (rate <= 0) {
+        fprintf(stderr, "DP-1: Rate must be positive\n");
+        return EXIT_FAILURE;
+    }
+    if (format_name != NULL && (ring_format = parse_ring_format(format_name)) == -1) {
+        fprintf(stderr, "DP-1: Unknown ring format '%s'%s\n", format_name,
+                (strcmp(format_name, "packed") == 0) ? " (packed needs the A-T symbol domain)" : "");
+        return EXIT_FAILURE;
+    }
+    if (fleet_text != NULL) {
+        fleet_size = parse_fleet_spec(fleet_text, fleet, MAX_PRODUCERS);
+        if (fleet_size <= 0) {
+            fprintf(stderr, "DP-1: Invalid fleet spec '%s' (1 to %d producers)\n", fleet_text, MAX_PRODUCERS);
+            return EXIT_FAILURE;
+        }
+        lane_count = fleet_size;
+    }
+    if (replay_path != NULL) {
+        if (fleet_size > 0) {
+            fprintf(stderr, "DP-1: Replay and fleet mode cannot be combined\n");
+            return EXIT_FAILURE;
+        }
+        lane_count = 1;
+    }
     
     // Set up signal handler
     signal(SIGINT, sigint_handler);
     
     // Create shared memory
-    shmid = create_shared_memory();
+    shmid = create_shared_memory(capacity, lane_count);
     if (shmid == -1) {
         fprintf(stderr, "Failed to create shared memory\n");
         return EXIT_FAILURE;
@@ -97,7 +369,15 @@ int main() {
     }
     
     // Initialize shared memory
-    init_shared_memory(shm);
+    init_shared_memory(shm, ring_mode, ring_format);
+    if ((record_payload = record_payload_from_env(shm)) == -1) {
+        detach_shared_memory(shm);
+        remove_shared_memory(shmid);
+        return EXIT_FAILURE;
+    }
+    printf("DP-1: Ring mode %s, format %s, %d lanes of %llu %s\n", ring_mode_name(ring_mode),
+           ring_format_name(ring_format), lane_count, (unsigned long long)lane_capacity(shm),
+           ring_unit_name(ring_format));
     
     // Create semaphore  (initialize once)
     semid = semget(0x1234, 1, IPC_CREAT | 0666); //Fixed key permissions
@@ -111,6 +391,26 @@ int main() {
     perror("DP-1: semctl initialization failed");
     return EXIT_FAILURE;
     }
+
+    // Replay mode: the same, with one replay producer
+    if (replay_path != NULL) {
+        int status = run_replay(replay_path, replay_fast);
+
+        detach_shared_memory(shm);
+        return status;
+    }
+
+    // Fleet mode: DP-1 only launches and reaps the producers and DC
+    if (fleet_size > 0) {
+        int status = run_fleet(fleet, fleet_size);
+
+        detach_shared_memory(shm);
+        return status;
+    }
+
+    // Classic mode: DP-1 is the first producer (lane 0), registered before DP-2 can start
+    producer_slot = register_producer(shm, policy, DP1_BATCH_SIZE, rate);
+    init_random(seed_from_env("HISTO_SEED", producer_slot));
     
     // Convert shmid to string for passing to DP-2
     snprintf(path, sizeof(path), "%s/DP-2/bin/DP-2", getenv("PWD"));
@@ -134,15 +434,25 @@ int main() {
     
     // Parent process (DP-1) continues here
     // Main loop */
+    pacer_init(&pacer, rate, DP1_BATCH_SIZE);
     while (running) {
+        // Sleep until the next deadline (2 seconds apart at the default rate)
+        count = pacer_wait(&pacer);
+        if (count <= 0) {
+            continue;
+        }
+
         // Generate and write letters
-        generate_and_write_letters();
-        
-        // Sleep for 2 seconds
-        sleep(2);
+        generate_and_write_letters(count);
+        record_producer_pacing(shm, producer_slot, pacer.emitted, pacer_elapsed_ns(&pacer));
     }
     
     // Clean up */
+    ring_flush(shm, semid, producer_slot);  // Packed format: the letters of a partial last word
+    record_producer_pacing(shm, producer_slot, pacer.emitted, pacer_elapsed_ns(&pacer));
+    printf("DP-1 (lane %d): target %.1f letters/s, achieved %.1f letters/s\n", producer_slot, rate,
+           pacer_achieved_rate(&pacer));
+    unregister_producer(shm, producer_slot);
     detach_shared_memory(shm);
     
     // Wait for child to terminate
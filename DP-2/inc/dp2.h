@@ -15,14 +15,25 @@
 #ifndef DP2_H
 #define DP2_H
 
+#include "../../common/inc/common.h"
+#include "../../common/inc/letter_log.h"
 #include <signal.h>
 
+// Default output: 1 letter every 1/20 second
+#define DP2_BATCH_SIZE 1
+#define DP2_RATE 20.0
+
 // Signal handler for SIGINT 
 void sigint_handler(int signum);
 
+// Replay producer
+int replay_letter_log(letter_log_reader_t *reader, int fast);
+
 //Global variables
 extern int running;  // Controls DP-2 main loop, set to 0 on SIGINT
 extern int shmid;  // Shared memory ID passed from DP-1 to DC
 extern int semid; // Semaphore ID used during letter writes
+extern int producer_slot; // Registry slot (and lane) claimed at startup
+extern int record_payload; // Largest record payload in record format ($HISTO_RECORD_PAYLOAD)
 
 #endif
\ No newline at end of file
@@ -6,20 +6,35 @@
  * DESCRIPTION:
  * This file contains the implementation for DP-2 (Data Producer 2). It attaches to existing shared memory
  * and semaphore, generates one random letter every 1/20 second, and writes it to the circular buffer. DP-2
- * also forks the DC process and passes the shared memory ID and PIDs of both producers.
+ * also forks the DC process and passes it the shared memory ID; DC finds the producers in the registry.
+ * Its overflow policy is chosen with -p or HISTO_DP2_POLICY. In fleet mode DP-1 launches many DP-2
+ * instances, each with its own batch size (-b) and rate (-r). Writes are paced by a drift-free token
+ * bucket (pacer.h), and the achieved rate is published in the registry and printed on exit.
+ * When DP-1 created the ring in record format, every letter is sent as a timestamped event record.
+ * With -P DP-2 is a replay producer: instead of generating letters it feeds a letter log recorded
+ * by DC (letter_log.h) into its lane, block by block at the recorded timing, or as fast as the ring
+ * takes them with -x, and exits at the end of the log.
  */
+#define _POSIX_C_SOURCE 200809L  // Enables POSIX features like getopt, kill and nanosleep
+
 #include "../inc/dp2.h"
 
 #include "../../common/inc/shared_memory.h"
 #include "../../common/inc/semaphore_utils.h"
 #include "../../common/inc/circular_buffer.h"
+#include "../../common/inc/producer_registry.h"
+#include "../../common/inc/pacer.h"
+#include "../../common/inc/letter_log.h"
 #include "../../common/inc/common.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
 #include <limits.h>
+#include <string.h>
+#include <time.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 
@@ -30,6 +45,8 @@ int running = 1;
 int shmid = -1;
 int semid = -1;
 shared_memory_t *shm = NULL;
+int producer_slot = -1;
+int record_payload = 0;
 
 /*
  * Name    : sigint_handler
@@ -43,33 +60,157 @@ void sigint_handler(int signum) {
     running = 0;
 }
 
+/*
+ * Name    : replay_letter_log
+ * Purpose : Replay producer: write every block of a letter log to our lane, at the recorded
+ *           timing (block offsets relative to the first block) or back to back
+ * Input   : Open log, fast flag (1 = no waiting between blocks)
+ * Outputs : Letters written to our lane, pacing published in the registry, summary printed
+ * Returns : EXIT_SUCCESS, or EXIT_FAILURE if the log is truncated or corrupt or a block could not be written
+ */
+int replay_letter_log(letter_log_reader_t *reader, int fast) {
+    struct timespec start;
+    struct timespec now;
+    int64_t first_offset_ns = -1;
+    int64_t elapsed_ns = 0;
+    uint64_t replayed = 0;
+    uint64_t stored = 0;  // Letters that made it into the ring (the rest were dropped by our policy)
+    int write_failed = 0;
+    int count = 0;
+    int written;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (running && (count = letter_log_next(reader)) > 0) {
+        if (!fast) {
+            struct timespec deadline = start;
+            int64_t delay_ns;
+
+            if (first_offset_ns < 0) {
+                first_offset_ns = reader->offset_ns;
+            }
+            delay_ns = reader->offset_ns - first_offset_ns;
+            deadline.tv_sec += (time_t)(delay_ns / 1000000000LL);
+            deadline.tv_nsec += (long)(delay_ns % 1000000000LL);
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+                continue;  // SIGINT, running is now 0
+            }
+        }
+
+        if (shm->ring_format == RING_FORMAT_RECORDS) {
+            written = write_letters_as_records(shm, semid, producer_slot, reader->letters, count, record_payload);
+        } else {
+            written = write_with_policy(shm, semid, producer_slot, reader->letters, count);
+        }
+        if (written < 0) {
+            write_failed = 1;  // Counted as dropped in the registry, but the replay is no longer faithful
+            break;
+        }
+        replayed += (uint64_t)count;
+        stored += (uint64_t)written;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed_ns = (int64_t)(now.tv_sec - start.tv_sec) * 1000000000LL + (now.tv_nsec - start.tv_nsec);
+        record_producer_pacing(shm, producer_slot, replayed, elapsed_ns);
+    }
+
+    printf("DP-2 (lane %d): replayed %llu letters (%llu written, %llu dropped) in %.3f s (%.1f letters/s, %s)\n",
+           producer_slot, (unsigned long long)replayed, (unsigned long long)stored,
+           (unsigned long long)(replayed - stored), elapsed_ns / 1e9,
+           (elapsed_ns > 0) ? replayed * 1e9 / elapsed_ns : 0.0, fast ? "maximum speed" : "recorded timing");
+    if (write_failed) {
+        fprintf(stderr, "DP-2: Could not write a block of %d letters after %llu letters, replay stopped\n", count,
+                (unsigned long long)replayed);
+        return EXIT_FAILURE;
+    }
+    if (count < 0) {
+        fprintf(stderr, "DP-2: Letter log is truncated or corrupt after %llu letters\n", (unsigned long long)replayed);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 /*
  * Name    : main
  * Purpose : Entry point for DP-2. Attaches to shared memory and semaphore, forks DC, and generates letters.
- * Input   : Command-line argument: <shmid>
+ * Input   : Command-line arguments: [-p drop|block|overwrite] [-b batch] [-r rate] [-f] [-P letter_log [-x]] <shmid>
+ *           (-p defaults to $HISTO_DP2_POLICY, then drop; -r to $HISTO_DP2_RATE, then 20 letters/s;
+ *           -b 1 by default, and batches grow automatically at rates above 1000 batches/s;
+ *           -f marks a fleet member, which leaves launching DC to DP-1;
+ *           -P replays a letter log instead of generating letters, -x at maximum speed)
  * Outputs : Writes letters to shared buffer, launches DC
  * Returns : EXIT_SUCCESS on normal exit, EXIT_FAILURE on error
  */
 int main(int argc, char *argv[]) {
-    pid_t dc_pid;
-    pid_t parent_pid = getppid();  // DP-1's PID
-    pid_t my_pid = getpid();       // DP-2's PID 
+    pid_t dc_pid = -1;
     char shmid_str[16];
-    char dp1_pid_str[16];
-    char dp2_pid_str[16];
+    const char *policy_name = getenv("HISTO_DP2_POLICY");
+    int policy = OVERFLOW_DROP_NEWEST;
+    int batch_size = DP2_BATCH_SIZE;
+    double rate = (getenv("HISTO_DP2_RATE") != NULL) ? atof(getenv("HISTO_DP2_RATE")) : DP2_RATE;
+    int fleet_member = 0;
+    const char *replay_path = NULL;
+    int replay_fast = 0;
+    static letter_log_reader_t replay;  // Static: holds a whole unpacked block
+    symbol_t *letters;
+    pacer_t pacer;
+    int max_emit;
+    int count;
+    int opt;
     
     // Set up signal handler 
     signal(SIGINT, sigint_handler);
+
+    // Parse options
+    while ((opt = getopt(argc, argv, "p:b:r:fP:x")) != -1) {
+        switch (opt) {
+        case 'p':
+            policy_name = optarg;
+            break;
+        case 'b':
+            batch_size = atoi(optarg);
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 'f':
+            fleet_member = 1;
+            break;
+        case 'P':
+            replay_path = optarg;
+            break;
+        case 'x':
+            replay_fast = 1;
+            break;
+        default:
+            argc = 0;  // Force the usage message below
+            break;
+        }
+    }
     
     // Check arguments */
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <shmid>\n", argv[0]);
+    if (argc - optind != 1) {
+        fprintf(stderr, "Usage: %s [-p drop|block|overwrite] [-b batch] [-r rate] [-f] [-P letter_log [-x]] <shmid>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (policy_name != NULL && (policy = parse_overflow_policy(policy_name)) == -1) {
+        fprintf(stderr, "DP-2: Unknown overflow policy '%s'\n", policy_name);
+        return EXIT_FAILURE;
+    }
+    if (batch_size <= 0 || rate <= 0) {
+        fprintf(stderr, "DP-2: Batch size and rate must be positive\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (replay_path != NULL && letter_log_open(&replay, replay_path) != 0) {
         return EXIT_FAILURE;
     }
     
     // Get shared memory ID from command line
-    shmid = atoi(argv[1]);
-    if (shmid <= 0) {
+    shmid = atoi(argv[optind]);
+    if (shmid < 0) {
         fprintf(stderr, "Invalid shared memory ID\n");
         return EXIT_FAILURE;
     }
@@ -81,59 +222,108 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
     
-    // Convert IDs to strings for passing to DC
+    // Convert ID to string for passing to DC
     snprintf(shmid_str, sizeof(shmid_str), "%d", shmid);
-    snprintf(dp1_pid_str, sizeof(dp1_pid_str), "%d", parent_pid);
-    snprintf(dp2_pid_str, sizeof(dp2_pid_str), "%d", my_pid);
     
-    // Fork DC process
-    dc_pid = fork();
-    if (dc_pid < 0) {
-        // Fork failed
-        perror("fork");
-        return EXIT_FAILURE;
-    } else if (dc_pid == 0) {
+    // Fork DC process (classic mode only; DP-1 launches DC for a fleet)
+    if (!fleet_member) {
+        dc_pid = fork();
+        if (dc_pid < 0) {
+            // Fork failed
+            perror("fork");
+            return EXIT_FAILURE;
+        } else if (dc_pid == 0) {
 
-        char path[PATH_MAX];
-        snprintf(path, sizeof(path), "%s/DC/bin/DC", getenv("PWD"));
-        printf("Launching DC from path: %s\n", path);
-        execl(path, "DC", shmid_str, dp1_pid_str, dp2_pid_str, NULL);
-        
-        // If exec fails
-        perror("execl");
-        exit(EXIT_FAILURE);
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/DC/bin/DC", getenv("PWD"));
+            printf("Launching DC from path: %s\n", path);
+            execl(path, "DC", shmid_str, NULL);
+            
+            // If exec fails
+            perror("execl");
+            exit(EXIT_FAILURE);
+        }
     }
     
-    // Attach to shared memory
-    if (attach_shared_memory(shmid, &shm) != 0) {
+    // Attach to shared memory and claim a lane in the producer registry
+    if (attach_shared_memory(shmid, &shm) != 0 ||
+        (producer_slot = register_producer(shm, policy, batch_size, rate)) == -1) {
         fprintf(stderr, "Failed to attach to shared memory\n");
-        kill(dc_pid, SIGINT);
-        waitpid(dc_pid, NULL, 0);
+        if (dc_pid > 0) {
+            kill(dc_pid, SIGINT);
+            waitpid(dc_pid, NULL, 0);
+        }
+        return EXIT_FAILURE;
+    }
+
+    // Record format: a payload that does not fit our lane would drop every batch
+    if ((record_payload = record_payload_from_env(shm)) == -1) {
+        unregister_producer(shm, producer_slot);
+        detach_shared_memory(shm);
+        if (dc_pid > 0) {
+            kill(dc_pid, SIGINT);
+            waitpid(dc_pid, NULL, 0);
+        }
+        return EXIT_FAILURE;
+    }
+
+    // Replay producer: the log decides what is written and when
+    if (replay_path != NULL) {
+        int status = replay_letter_log(&replay, replay_fast);
+
+        ring_flush(shm, semid, producer_slot);
+        letter_log_close_reader(&replay);
+        unregister_producer(shm, producer_slot);
+        detach_shared_memory(shm);
+        if (dc_pid > 0) {
+            waitpid(dc_pid, NULL, 0);
+        }
+        return status;
+    }
+
+    // Seed our own generator, repeatably if HISTO_SEED is set (each lane still gets its own sequence)
+    init_random(seed_from_env("HISTO_SEED", producer_slot));
+
+    // The pacer decides how many letters each tick emits, size the batch buffer for the largest
+    max_emit = pacer_init(&pacer, rate, batch_size);
+    letters = malloc((size_t)max_emit * sizeof(symbol_t));
+    if (letters == NULL) {
+        perror("malloc");
+        unregister_producer(shm, producer_slot);
         return EXIT_FAILURE;
     }
     
     // Main loop
     while (running) {
-        char letter = generate_random_letter();
-        
-        // Acquire semaphore
-        semaphore_wait(semid);
-        
-        // Write single letter to buffer
-        write_to_buffer(shm, letter);
-        
-        // Release semaphore */
-        semaphore_signal(semid);
-        
-        // Sleep for 1/20 of a second (50 ms)
-        usleep(50000);
+        // Sleep until the next absolute deadline (interrupted by SIGINT on shutdown)
+        count = pacer_wait(&pacer);
+        if (count <= 0) {
+            continue;
+        }
+
+        // Generate the batch straight into our lane, applying our overflow policy (records are framed from a copy)
+        if (shm->ring_format == RING_FORMAT_RECORDS) {
+            generate_random_letters(letters, count);
+            write_letters_as_records(shm, semid, producer_slot, letters, count, record_payload);
+        } else {
+            write_in_place(shm, semid, producer_slot, generate_random_letters, count);
+        }
+        record_producer_pacing(shm, producer_slot, pacer.emitted, pacer_elapsed_ns(&pacer));
     }
     
     // Clean up 
+    ring_flush(shm, semid, producer_slot);  // Packed format: the letters of a partial last word
+    record_producer_pacing(shm, producer_slot, pacer.emitted, pacer_elapsed_ns(&pacer));
+    printf("DP-2 (lane %d): target %.1f letters/s, achieved %.1f letters/s\n", producer_slot, rate,
+           pacer_achieved_rate(&pacer));
+    free(letters);
+    unregister_producer(shm, producer_slot);
     detach_shared_memory(shm);
     
     // Wait for child to terminate
-    waitpid(dc_pid, NULL, 0);
+    if (dc_pid > 0) {
+        waitpid(dc_pid, NULL, 0);
+    }
     
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
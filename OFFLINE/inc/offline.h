@@ -0,0 +1,73 @@
+/*
+ * FILE: offline.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header file declares the data structures and function prototypes used by histo-offline,
+ * the batch counter for archived letter data. Input files (raw symbols or letter logs) are mapped
+ * and cut into jobs of about a chunk each; a pool of worker threads takes jobs from a shared
+ * index and counts them with DC's kernels into a private histogram, and the partial histograms
+ * are added up once every job is done.
+ */
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+#include "../../common/inc/common.h"
+#include "../../common/inc/shared_memory.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Job size in MiB unless -c says otherwise
+#define OFFLINE_DEFAULT_CHUNK_MB 16
+// Most worker threads
+#define OFFLINE_MAX_THREADS 256
+
+// Output formats
+#define OUTPUT_HISTOGRAM 0  // DC's histogram frame
+#define OUTPUT_CSV 1        // symbol,count lines
+#define OUTPUT_JSON 2       // One JSON object
+
+// Input formats
+#define INPUT_RAW 0  // symbol_t after symbol_t
+#define INPUT_LOG 1  // Letter log (letter_log.h)
+
+// One mapped input file
+typedef struct {
+    const char *path;
+    const unsigned char *data;  // Mapping, NULL for an empty file
+    size_t size;
+    int format;                 // INPUT_*
+} input_file_t;
+
+// One job: a byte range of a file, whole blocks in a letter log
+typedef struct {
+    const input_file_t *file;
+    size_t begin;
+    size_t end;
+} offline_job_t;
+
+// One worker thread and its partial histogram, on cache lines of its own
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) uint64_t counts[LETTER_RANGE];
+    uint64_t letters;    // Symbols counted
+    uint64_t rejected;   // Symbols outside the domain
+    uint64_t jobs;       // Jobs taken
+    pthread_t thread;
+} offline_worker_t;
+
+// Input handling
+int map_input(input_file_t *file, const char *path, int force_raw);
+void unmap_input(input_file_t *file);
+int add_jobs(const input_file_t *file, size_t chunk_bytes);
+
+// Counting
+void *worker_main(void *arg);
+void count_job(offline_worker_t *worker, const offline_job_t *job);
+
+// Output
+void print_csv(const uint64_t *counts);
+void print_json(const uint64_t *counts, uint64_t letters, uint64_t rejected, double seconds);
+
+#endif /* OFFLINE_H */
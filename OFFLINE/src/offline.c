@@ -0,0 +1,473 @@
+/*
+ * FILE: offline.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This file implements histo-offline, which recounts archived letter data outside the live
+ * pipeline. Every input file is mapped read-only and recognized by its header: a letter log
+ * (DC -w) is counted straight from its packed words with a packed_counter_t, anything else is
+ * taken as raw symbols and counted with count_letters, the same kernels DC uses. Raw files are
+ * cut into chunk-sized jobs; logs are indexed block by block (one header read per 4096 letters)
+ * and cut at the first block boundary past each chunk. Worker threads take the next job from a
+ * shared atomic index, so a slow job never holds up the others, and add to a private,
+ * cache-line-aligned histogram; nothing is shared while counting, and the partials are summed
+ * once at the end. The result is printed as DC's histogram frame, as CSV or as JSON.
+ */
+#define _DEFAULT_SOURCE  // Enables madvise, sysconf and clock_gettime
+
+#include "../inc/offline.h"
+
+#include "../../common/inc/histogram_kernel.h"
+#include "../../common/inc/histogram_render.h"
+#include "../../common/inc/letter_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Global variables
+offline_job_t *jobs = NULL;   // Every job of every file, in file order
+size_t job_count = 0;
+size_t job_capacity = 0;
+_Atomic size_t next_job = 0;  // Next job a worker takes
+
+/*
+ * Name    : monotonic_seconds
+ * Purpose : Time base for the elapsed time in the summary
+ * Input   : None
+ * Outputs : None
+ * Returns : CLOCK_MONOTONIC in seconds
+ */
+static double monotonic_seconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/*
+ * Name    : map_input
+ * Purpose : Map an input file and decide whether it is a letter log or raw symbols
+ * Input   : File to fill in, path, 1 to treat it as raw symbols whatever its header says
+ * Outputs : File mapped (empty files are not), format set
+ * Returns : 0 on success, -1 if the file cannot be read or is a log of another symbol domain
+ */
+int map_input(input_file_t *file, const char *path, int force_raw) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    memset(file, 0, sizeof(*file));
+    file->path = path;
+    file->format = INPUT_RAW;
+    if (fd == -1 || fstat(fd, &info) == -1) {
+        fprintf(stderr, "histo-offline: Cannot open %s: %s\n", path, strerror(errno));
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+    file->size = (size_t)info.st_size;
+    if (file->size > 0) {
+        void *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "histo-offline: Cannot map %s: %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        // Each job is read front to back, let the kernel read ahead
+        madvise(data, file->size, MADV_SEQUENTIAL);
+        file->data = data;
+    }
+    close(fd);  // The mapping keeps the file
+
+    if (!force_raw && file->size >= sizeof(letter_log_header_t)) {
+        letter_log_header_t header;
+
+        memcpy(&header, file->data, sizeof(header));
+        if (header.magic == LETTER_LOG_MAGIC) {
+            if (header.version != LETTER_LOG_VERSION || header.symbol_bins != LETTER_RANGE ||
+                header.bits_per_symbol != LETTER_LOG_BITS) {
+                fprintf(stderr, "histo-offline: %s is a letter log of another symbol domain or version\n", path);
+                unmap_input(file);
+                return -1;
+            }
+            file->format = INPUT_LOG;
+        }
+    }
+    if (file->format == INPUT_RAW && file->size % sizeof(symbol_t) != 0) {
+        fprintf(stderr, "histo-offline: %s ends in a partial symbol, the last byte is ignored\n", path);
+    }
+    return 0;
+}
+
+/*
+ * Name    : unmap_input
+ * Purpose : Release an input file's mapping
+ * Input   : File
+ * Outputs : Mapping removed
+ * Returns : None
+ */
+void unmap_input(input_file_t *file) {
+    if (file->data != NULL) {
+        munmap((void *)file->data, file->size);
+        file->data = NULL;
+    }
+}
+
+/*
+ * Name    : push_job
+ * Purpose : Append one job to the job list
+ * Input   : File, byte range
+ * Outputs : jobs grown if needed
+ * Returns : 0 on success, -1 if out of memory
+ */
+static int push_job(const input_file_t *file, size_t begin, size_t end) {
+    if (begin == end) {
+        return 0;
+    }
+    if (job_count == job_capacity) {
+        size_t capacity = (job_capacity == 0) ? 256 : job_capacity * 2;
+        offline_job_t *grown = realloc(jobs, capacity * sizeof(*jobs));
+
+        if (grown == NULL) {
+            perror("histo-offline: realloc");
+            return -1;
+        }
+        jobs = grown;
+        job_capacity = capacity;
+    }
+    jobs[job_count].file = file;
+    jobs[job_count].begin = begin;
+    jobs[job_count].end = end;
+    job_count++;
+    return 0;
+}
+
+/*
+ * Name    : add_jobs
+ * Purpose : Cut a mapped file into jobs of about chunk_bytes each
+ * Input   : File, chunk size in bytes
+ * Outputs : Jobs appended; a corrupt log is only counted up to its last whole block
+ * Returns : 0 on success, -1 if out of memory
+ */
+int add_jobs(const input_file_t *file, size_t chunk_bytes) {
+    size_t begin;
+    size_t at;
+
+    if (file->format == INPUT_RAW) {
+        size_t end = file->size - file->size % sizeof(symbol_t);
+
+        chunk_bytes -= chunk_bytes % sizeof(symbol_t);
+        for (begin = 0; begin < end; begin += chunk_bytes) {
+            if (push_job(file, begin, (end - begin > chunk_bytes) ? begin + chunk_bytes : end) != 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    // Letter log: walk the block headers, cut at the first block boundary past each chunk
+    begin = at = sizeof(letter_log_header_t);
+    while (at < file->size) {
+        letter_log_block_header_t block;
+        size_t block_size;
+
+        if (file->size - at < sizeof(block)) {
+            break;
+        }
+        memcpy(&block, file->data + at, sizeof(block));
+        block_size = sizeof(block) + PACKED_WORDS((size_t)block.count) * sizeof(uint64_t);
+        if (block.count == 0 || block.count > LETTER_LOG_BLOCK_LETTERS || block_size > file->size - at) {
+            break;
+        }
+        at += block_size;
+        if (at - begin >= chunk_bytes) {
+            if (push_job(file, begin, at) != 0) {
+                return -1;
+            }
+            begin = at;
+        }
+    }
+    if (at < file->size) {
+        fprintf(stderr, "histo-offline: %s is truncated or corrupt at byte %zu, counting the blocks before it\n",
+                file->path, at);
+    }
+    return push_job(file, begin, at);
+}
+
+/*
+ * Name    : count_job
+ * Purpose : Count one job into a worker's partial histogram
+ * Input   : Worker, job
+ * Outputs : Worker's counts, letters and rejected updated
+ * Returns : None
+ */
+void count_job(offline_worker_t *worker, const offline_job_t *job) {
+    const unsigned char *data = job->file->data;
+    packed_counter_t counter;
+    uint64_t letters = 0;
+    size_t rejected;
+
+    if (job->file->format == INPUT_RAW) {
+        size_t count = (job->end - job->begin) / sizeof(symbol_t);
+
+        rejected = count_letters((const symbol_t *)(data + job->begin), count, worker->counts);
+        worker->letters += count - rejected;
+        worker->rejected += rejected;
+        return;
+    }
+
+    // Whole blocks, validated by add_jobs; the words of a block are 8-byte aligned in the mapping.
+    // A block is only 4096 letters, so the whole job shares one set of sub-histograms, merged once
+    packed_counter_init(&counter);
+    rejected = 0;
+    for (size_t at = job->begin; at < job->end;) {
+        letter_log_block_header_t block;
+
+        memcpy(&block, data + at, sizeof(block));
+        at += sizeof(block);
+        rejected += packed_counter_add(&counter, (const uint64_t *)(data + at), block.count, worker->counts);
+        letters += block.count;
+        at += PACKED_WORDS((size_t)block.count) * sizeof(uint64_t);
+    }
+    rejected += packed_counter_merge(&counter, worker->counts);
+    worker->letters += letters - rejected;
+    worker->rejected += rejected;
+}
+
+/*
+ * Name    : worker_main
+ * Purpose : Worker thread: take jobs until none are left
+ * Input   : The thread's offline_worker_t
+ * Outputs : Partial histogram filled
+ * Returns : NULL
+ */
+void *worker_main(void *arg) {
+    offline_worker_t *worker = arg;
+    size_t job;
+
+    while ((job = atomic_fetch_add_explicit(&next_job, 1, memory_order_relaxed)) < job_count) {
+        count_job(worker, &jobs[job]);
+        worker->jobs++;
+    }
+    return NULL;
+}
+
+/*
+ * Name    : print_csv
+ * Purpose : Print the histogram as CSV
+ * Input   : LETTER_RANGE counts
+ * Outputs : Header line and one symbol,count line per bin on stdout
+ * Returns : None
+ */
+void print_csv(const uint64_t *counts) {
+    char label[16];
+
+    printf("symbol,count\n");
+    for (int bin = 0; bin < LETTER_RANGE; bin++) {
+        format_symbol(label, sizeof(label), bin);
+        printf("%s,%llu\n", label, (unsigned long long)counts[bin]);
+    }
+}
+
+/*
+ * Name    : print_json
+ * Purpose : Print the histogram and totals as one JSON object
+ * Input   : LETTER_RANGE counts, letters counted, letters rejected, elapsed seconds
+ * Outputs : One line on stdout
+ * Returns : None
+ */
+void print_json(const uint64_t *counts, uint64_t letters, uint64_t rejected, double seconds) {
+    char label[16];
+
+    printf("{\"letters\":%llu,\"rejected\":%llu,\"seconds\":%.3f,\"counts\":{",
+           (unsigned long long)letters, (unsigned long long)rejected, seconds);
+    for (int bin = 0; bin < LETTER_RANGE; bin++) {
+        format_symbol(label, sizeof(label), bin);
+        printf("%s\"%s\":%llu", (bin > 0) ? "," : "", label, (unsigned long long)counts[bin]);
+    }
+    printf("}}\n");
+}
+
+/*
+ * Name    : print_usage
+ * Purpose : Describe the command line
+ * Input   : Program name
+ * Outputs : Usage on stderr
+ * Returns : None
+ */
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-t threads] [-c chunk_mb] [-k auto|scalar|sse2|avx2] "
+                    "[-b classic|log|auto] [-o histogram|csv|json] [-r] file...\n", program);
+}
+
+/*
+ * Name    : main
+ * Purpose : Entry point for histo-offline
+ * Input   : Command-line arguments [-t threads] [-c chunk_mb] [-k kernel] [-b bar_mode]
+ *           [-o histogram|csv|json] [-r] file...
+ * Outputs : Histogram of every file together on stdout, summary on stderr
+ * Returns : EXIT_SUCCESS, or EXIT_FAILURE on bad arguments or an unreadable input
+ */
+int main(int argc, char *argv[]) {
+    const char *kernel_name = NULL;
+    const char *bar_mode_name = NULL;
+    const char *output_name = "histogram";
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    long chunk_mb = OFFLINE_DEFAULT_CHUNK_MB;
+    int force_raw = 0;
+    int output = OUTPUT_HISTOGRAM;
+    int bar_mode = BAR_MODE_CLASSIC;
+    input_file_t *files;
+    offline_worker_t *workers;
+    uint64_t *counts;
+    uint64_t letters = 0, rejected = 0, bytes = 0;
+    int file_count;
+    int status = EXIT_SUCCESS;
+    double started, elapsed;
+    int opt;
+
+    // Parse options
+    while ((opt = getopt(argc, argv, "t:c:k:b:o:r")) != -1) {
+        switch (opt) {
+        case 't':
+            threads = atol(optarg);
+            break;
+        case 'c':
+            chunk_mb = atol(optarg);
+            break;
+        case 'k':
+            kernel_name = optarg;
+            break;
+        case 'b':
+            bar_mode_name = optarg;
+            break;
+        case 'o':
+            output_name = optarg;
+            break;
+        case 'r':
+            force_raw = 1;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (threads < 1 || threads > OFFLINE_MAX_THREADS || chunk_mb < 1) {
+        fprintf(stderr, "histo-offline: Threads must be 1..%d and the chunk at least 1 MiB\n", OFFLINE_MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+    if (strcmp(output_name, "csv") == 0) {
+        output = OUTPUT_CSV;
+    } else if (strcmp(output_name, "json") == 0) {
+        output = OUTPUT_JSON;
+    } else if (strcmp(output_name, "histogram") != 0) {
+        fprintf(stderr, "histo-offline: Unknown output '%s'\n", output_name);
+        return EXIT_FAILURE;
+    }
+    if (bar_mode_name != NULL && (bar_mode = parse_bar_mode(bar_mode_name)) == -1) {
+        fprintf(stderr, "histo-offline: Unknown bar mode '%s'\n", bar_mode_name);
+        return EXIT_FAILURE;
+    }
+    if (select_count_kernel(kernel_name) != 0) {
+        fprintf(stderr, "histo-offline: Counting kernel '%s' is unknown or not supported by this CPU\n", kernel_name);
+        return EXIT_FAILURE;
+    }
+
+    // Map every input and cut it into jobs
+    started = monotonic_seconds();
+    file_count = argc - optind;
+    files = calloc((size_t)file_count, sizeof(*files));
+    counts = calloc(LETTER_RANGE, sizeof(*counts));
+    if (files == NULL || counts == NULL) {
+        perror("histo-offline: calloc");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < file_count; i++) {
+        if (map_input(&files[i], argv[optind + i], force_raw) != 0 ||
+            add_jobs(&files[i], (size_t)chunk_mb << 20) != 0) {
+            status = EXIT_FAILURE;
+            break;
+        }
+        bytes += files[i].size;
+    }
+
+    // Count: no more threads than jobs, each with its own histogram
+    if (status == EXIT_SUCCESS) {
+        if ((size_t)threads > job_count) {
+            threads = (job_count > 0) ? (long)job_count : 1;
+        }
+        workers = aligned_alloc(CACHE_LINE_SIZE, (size_t)threads * sizeof(*workers));
+        if (workers == NULL) {
+            perror("histo-offline: aligned_alloc");
+            return EXIT_FAILURE;
+        }
+        memset(workers, 0, (size_t)threads * sizeof(*workers));
+        for (long i = 1; i < threads; i++) {
+            if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+                fprintf(stderr, "histo-offline: Cannot start worker %ld, counting with %ld\n", i, i);
+                threads = i;
+                break;
+            }
+        }
+        worker_main(&workers[0]);  // The main thread is worker 0
+        for (long i = 1; i < threads; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        // Merge the partial histograms
+        for (long i = 0; i < threads; i++) {
+            for (int bin = 0; bin < LETTER_RANGE; bin++) {
+                counts[bin] += workers[i].counts[bin];
+            }
+            letters += workers[i].letters;
+            rejected += workers[i].rejected;
+        }
+        free(workers);
+        elapsed = monotonic_seconds() - started;
+
+        // Report
+        if (output == OUTPUT_CSV) {
+            print_csv(counts);
+        } else if (output == OUTPUT_JSON) {
+            print_json(counts, letters, rejected, elapsed);
+        } else {
+            histogram_renderer_t renderer;
+
+            if (renderer_init(&renderer, STDOUT_FILENO, bar_mode, RENDER_DEFAULT_WIDTH) != 0) {
+                fprintf(stderr, "histo-offline: Failed to set up the histogram renderer\n");
+                status = EXIT_FAILURE;
+            } else {
+                render_histogram(&renderer, counts);
+                renderer_free(&renderer);
+            }
+        }
+        fflush(stdout);
+        fprintf(stderr, "histo-offline: %d file(s), %llu bytes, %llu letters (%llu rejected), %zu jobs, "
+                        "%ld thread(s), %s kernel, %.3f s, %.1f MB/s\n",
+                file_count, (unsigned long long)bytes, (unsigned long long)letters, (unsigned long long)rejected,
+                job_count, threads, count_kernel_name(), elapsed, (elapsed > 0) ? (double)bytes / elapsed / 1e6 : 0.0);
+    }
+
+    // Clean up
+    for (int i = 0; i < file_count; i++) {
+        unmap_input(&files[i]);
+    }
+    free(files);
+    free(counts);
+    free(jobs);
+    return status;
+}
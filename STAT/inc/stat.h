@@ -0,0 +1,32 @@
+/*
+ * FILE: stat.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header file declares the function prototypes and global variables used by
+ * histo-stat, the vmstat-style monitor of the ring's runtime statistics.
+ */
+#ifndef STAT_H
+#define STAT_H
+
+#include <signal.h>
+#include "../../common/inc/ring_stats.h"
+
+// Sample interval in milliseconds unless -i says otherwise
+#define STAT_DEFAULT_INTERVAL_MS 1000
+// Column headings are repeated after this many rows, as vmstat does
+#define STAT_HEADER_EVERY 20
+
+// Signal handler for SIGINT
+void sigint_handler(int signum);
+
+// Display helpers
+void print_banner(const shared_memory_t *shm, long interval_ms);
+void print_header(void);
+void print_row(const ring_stats_t *now, const ring_stats_t *before);
+
+// Global variables
+extern volatile sig_atomic_t running;  // Cleared by SIGINT to stop sampling
+
+#endif /* STAT_H */
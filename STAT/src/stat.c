@@ -0,0 +1,171 @@
+/*
+ * FILE: stat.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This file implements histo-stat, a vmstat-style monitor of the ring. It attaches to the shared
+ * segment read-only, samples the producers' and DC's counters (ring_stats.c) every interval and
+ * prints one row of per-interval deltas: letters written, read, dropped and overwritten, time the
+ * producers spent blocked or waiting for the semaphore, DC's semaphore wait, ring occupancy, DC's
+ * read passes and wakeups, and how long ago DC last read. The first row, like vmstat's, covers
+ * everything since the ring was created. A growing backlog shows as rising used% with read below
+ * written; a starved or stuck DC shows as a growing idle time.
+ */
+#define _POSIX_C_SOURCE 200809L  // Enables getopt and nanosleep
+
+#include "../inc/stat.h"
+
+#include "../../common/inc/circular_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Global variables
+volatile sig_atomic_t running = 1;
+
+/*
+ * Name    : sigint_handler
+ * Purpose : Stop sampling on SIGINT
+ * Input   : signum (unused)
+ * Outputs : Sets running = 0
+ * Returns : None
+ */
+void sigint_handler(int signum) {
+    (void)signum;
+    running = 0;
+}
+
+/*
+ * Name    : print_banner
+ * Purpose : Describe the ring being monitored and the units of the columns
+ * Input   : Pointer to shared memory, interval in milliseconds
+ * Outputs : One line on stdout
+ * Returns : None
+ */
+void print_banner(const shared_memory_t *shm, long interval_ms) {
+    int records = (shm->ring_format == RING_FORMAT_RECORDS);
+
+    printf("histo-stat: %u lanes x %llu %s, %s, %s format, every %ld ms (counts are %s, used is %s)\n",
+           shm->header.lane_count, (unsigned long long)lane_capacity(shm), ring_unit_name(shm->ring_format),
+           ring_mode_name(shm->ring_mode), ring_format_name(shm->ring_format), interval_ms,
+           records ? "records" : "letters", ring_unit_name(shm->ring_format));
+}
+
+/*
+ * Name    : print_header
+ * Purpose : Print the column headings
+ * Input   : None
+ * Outputs : Two lines on stdout
+ * Returns : None
+ */
+void print_header(void) {
+    printf("prod ------------------ counts ------------------- ------ wait ms ------ ----- ring ----- ------ DC ------ - idle --\n");
+    printf("  up     written        read     dropped  overwrit  blocked plock  clock       used used%%  drains  wakeups        ms\n");
+}
+
+/*
+ * Name    : print_row
+ * Purpose : Print the deltas between two samples
+ * Input   : Newer sample, older sample (all zero for the since-start row)
+ * Outputs : One line on stdout
+ * Returns : None
+ */
+void print_row(const ring_stats_t *now, const ring_stats_t *before) {
+    double used_percent = (now->capacity > 0) ? 100.0 * (double)now->used / (double)now->capacity : 0.0;
+    char idle[24];
+
+    if (now->consumer_attached) {
+        snprintf(idle, sizeof(idle), "%llu",
+                 (unsigned long long)((now->taken_ns > now->last_drain_ns) ?
+                                      (now->taken_ns - now->last_drain_ns) / 1000000ULL : 0));
+    } else {
+        snprintf(idle, sizeof(idle), "no DC");
+    }
+
+    printf("%4d %11llu %11llu %11llu %9llu %8llu %5llu %6llu %10llu %5.1f %7llu %8llu %9s\n",
+           now->active_producers,
+           (unsigned long long)(now->written - before->written),
+           (unsigned long long)(now->consumed - before->consumed),
+           (unsigned long long)(now->dropped - before->dropped),
+           (unsigned long long)(now->overwritten - before->overwritten),
+           (unsigned long long)((now->blocked_ns - before->blocked_ns) / 1000000ULL),
+           (unsigned long long)((now->producer_lock_ns - before->producer_lock_ns) / 1000000ULL),
+           (unsigned long long)((now->consumer_lock_ns - before->consumer_lock_ns) / 1000000ULL),
+           (unsigned long long)now->used, used_percent,
+           (unsigned long long)(now->drains - before->drains),
+           (unsigned long long)(now->wakeups - before->wakeups), idle);
+    fflush(stdout);
+}
+
+/*
+ * Name    : main
+ * Purpose : Entry point for histo-stat
+ * Input   : Command-line arguments [-i interval_ms] [-n samples] (-n 0 samples until Ctrl+C)
+ * Outputs : One row of statistics every interval
+ * Returns : EXIT_SUCCESS, or EXIT_FAILURE if there is no ring to monitor
+ */
+int main(int argc, char *argv[]) {
+    const shared_memory_t *shm = NULL;
+    ring_stats_t before, now;
+    long interval_ms = STAT_DEFAULT_INTERVAL_MS;
+    long samples = 0;
+    struct timespec interval;
+    int shmid;
+    int opt;
+
+    // Parse options
+    while ((opt = getopt(argc, argv, "i:n:")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval_ms = atol(optarg);
+            break;
+        case 'n':
+            samples = atol(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i interval_ms] [-n samples]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (interval_ms <= 0 || samples < 0) {
+        fprintf(stderr, "histo-stat: Interval must be positive and samples not negative\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set up signal handler
+    signal(SIGINT, sigint_handler);
+
+    // Attach read-only; nobody in the system knows we are here
+    shmid = shmget(SHM_KEY, 0, 0);
+    if (shmid == -1) {
+        fprintf(stderr, "histo-stat: No shared segment (is DP-1 running?)\n");
+        return EXIT_FAILURE;
+    }
+    if (attach_shared_memory_readonly(shmid, &shm) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    interval.tv_sec = interval_ms / 1000;
+    interval.tv_nsec = (interval_ms % 1000) * 1000000L;
+    print_banner(shm, interval_ms);
+    memset(&before, 0, sizeof(before));
+    for (long shown = 0; running && (samples == 0 || shown < samples); shown++) {
+        if (shown % STAT_HEADER_EVERY == 0) {
+            print_header();
+        }
+        collect_ring_stats(shm, &now);
+        print_row(&now, &before);
+        before = now;
+        if (samples == 0 || shown + 1 < samples) {
+            nanosleep(&interval, NULL);
+        }
+    }
+
+    // Clean up
+    detach_shared_memory(shm);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+/*
+ * FILE: view.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header file declares the function prototypes and global variables used by
+ * histo-view, the read-only monitor that displays DC's published histogram snapshot.
+ */
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <signal.h>
+#include "../../common/inc/snapshot.h"
+#include "../../common/inc/histogram_render.h"
+
+// Refresh interval in milliseconds unless -i says otherwise
+#define VIEW_DEFAULT_INTERVAL_MS 1000
+
+// Signal handler for SIGINT
+void sigint_handler(int signum);
+
+// Display helpers
+void display_snapshot(histogram_renderer_t *renderer, const histogram_snapshot_t *snapshot);
+void display_ring_stats(const histogram_snapshot_t *snapshot);
+
+// Global variables
+extern volatile sig_atomic_t running;  // Cleared by SIGINT to stop the refresh loop
+
+#endif /* VIEW_H */
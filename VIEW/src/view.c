@@ -0,0 +1,179 @@
+/*
+ * FILE: view.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This file implements histo-view, a read-only monitor for a running DC. It attaches to the
+ * snapshot segment DC publishes (never to the ring itself), copies out a consistent snapshot
+ * through the seqlock and displays the histogram, the rolling windows and the ring statistics.
+ * Any number of viewers can run at once; DC never waits for them. The viewer exits on SIGINT,
+ * after -n refreshes, or once DC has published its final snapshot.
+ */
+#define _POSIX_C_SOURCE 200809L  // Enables getopt and nanosleep
+
+#include "../inc/view.h"
+
+#include "../../common/inc/circular_buffer.h"
+#include "../../common/inc/common.h"
+#include "../../common/inc/sliding_window.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Global variables
+volatile sig_atomic_t running = 1;
+
+/*
+ * Name    : sigint_handler
+ * Purpose : Stop the refresh loop on SIGINT
+ * Input   : signum (unused)
+ * Outputs : Sets running = 0
+ * Returns : None
+ */
+void sigint_handler(int signum) {
+    (void)signum;
+    running = 0;
+}
+
+/*
+ * Name    : display_ring_stats
+ * Purpose : Displays the ring and producer totals carried in a snapshot
+ * Input   : Snapshot
+ * Outputs : Printed ring statistics on terminal
+ * Returns : None
+ */
+void display_ring_stats(const histogram_snapshot_t *snapshot) {
+    // Lane sizes and fill are in the ring's own unit, the producer counters in records or letters
+    printf("\nRing: %d lanes of %llu %s%s, %d active producers, %llu DC wakeups\n", snapshot->lane_count,
+           (unsigned long long)snapshot->capacity,
+           (snapshot->ring_format == RING_FORMAT_RECORDS) ? "record " :
+           (snapshot->ring_format == RING_FORMAT_PACKED) ? "packed " : "",
+           ring_unit_name(snapshot->ring_format), snapshot->active_producers,
+           (unsigned long long)snapshot->wakeups);
+    printf("Producers: %llu %s written, %llu dropped, %llu overwritten\n", (unsigned long long)snapshot->written,
+           (snapshot->ring_format == RING_FORMAT_RECORDS) ? "records" : "letters",
+           (unsigned long long)snapshot->dropped, (unsigned long long)snapshot->overwritten);
+    printf("Lane fill:");
+    for (int lane = 0; lane < snapshot->lane_count && lane < MAX_PRODUCERS; lane++) {
+        printf(" %d:%.1f%%", lane,
+               snapshot->capacity > 0 ? 100.0 * (double)snapshot->lane_used[lane] / (double)snapshot->capacity : 0.0);
+    }
+    printf("\n");
+}
+
+/*
+ * Name    : display_snapshot
+ * Purpose : Displays one snapshot: histogram, rolling windows, latency and ring statistics
+ * Input   : Renderer, snapshot
+ * Outputs : Printed snapshot on terminal
+ * Returns : None
+ */
+void display_snapshot(histogram_renderer_t *renderer, const histogram_snapshot_t *snapshot) {
+    fflush(stdout);  // The renderer writes to the descriptor directly
+    render_histogram(renderer, snapshot->counts);
+
+    printf("\n%-6s %12s %10s\n", "Window", "Letters", "Rate/s");
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        uint64_t total = 0;
+
+        for (int i = 0; i < LETTER_RANGE; i++) {
+            total += snapshot->window_counts[w][i];
+        }
+        printf("%-6s %12llu %10.1f\n", window_name(w), (unsigned long long)total,
+               snapshot->window_seconds[w] > 0 ? (double)total / snapshot->window_seconds[w] : 0.0);
+    }
+
+    if (snapshot->latency_count > 0) {
+        printf("\nLatency (enqueue to count, %llu records, us): p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+               (unsigned long long)snapshot->latency_count, snapshot->latency_p50_ns / 1000.0,
+               snapshot->latency_p99_ns / 1000.0, snapshot->latency_p999_ns / 1000.0,
+               snapshot->latency_max_ns / 1000.0);
+    }
+
+    display_ring_stats(snapshot);
+    printf("Snapshot %llu from DC %d%s\n", (unsigned long long)snapshot->publish_count, (int)snapshot->dc_pid,
+           snapshot->dc_running ? "" : " (final)");
+    fflush(stdout);
+}
+
+/*
+ * Name    : main
+ * Purpose : Entry point for histo-view
+ * Input   : Command-line arguments [-i interval_ms] [-n refreshes] [-b classic|log|auto]
+ *           (-b defaults to $HISTO_BAR_MODE, then classic; -n 0 refreshes until DC stops)
+ * Outputs : Snapshot displayed every interval
+ * Returns : EXIT_SUCCESS, or EXIT_FAILURE if there is no DC snapshot to view
+ */
+int main(int argc, char *argv[]) {
+    const snapshot_region_t *region = NULL;
+    static histogram_snapshot_t snapshot;  // Static: with a wide symbol domain it is too big for the stack
+    histogram_renderer_t renderer;
+    const char *bar_mode_name = getenv("HISTO_BAR_MODE");
+    int bar_mode = BAR_MODE_CLASSIC;
+    long interval_ms = VIEW_DEFAULT_INTERVAL_MS;
+    long refreshes = 0;
+    struct timespec interval;
+    int opt;
+
+    // Parse options
+    while ((opt = getopt(argc, argv, "i:n:b:")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval_ms = atol(optarg);
+            break;
+        case 'n':
+            refreshes = atol(optarg);
+            break;
+        case 'b':
+            bar_mode_name = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i interval_ms] [-n refreshes] [-b classic|log|auto]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (interval_ms <= 0 || refreshes < 0) {
+        fprintf(stderr, "histo-view: Interval must be positive and refreshes not negative\n");
+        return EXIT_FAILURE;
+    }
+    if (bar_mode_name != NULL && (bar_mode = parse_bar_mode(bar_mode_name)) == -1) {
+        fprintf(stderr, "histo-view: Unknown bar mode '%s'\n", bar_mode_name);
+        return EXIT_FAILURE;
+    }
+
+    // Set up signal handler
+    signal(SIGINT, sigint_handler);
+
+    // Attach read-only; DC does not know or care that we are here
+    if (attach_snapshot_region(&region) != 0 ||
+        renderer_init(&renderer, STDOUT_FILENO, bar_mode, RENDER_DEFAULT_WIDTH) != 0) {
+        detach_snapshot_region(region);
+        return EXIT_FAILURE;
+    }
+
+    interval.tv_sec = interval_ms / 1000;
+    interval.tv_nsec = (interval_ms % 1000) * 1000000L;
+    for (long shown = 0; running && (refreshes == 0 || shown < refreshes);) {
+        if (read_snapshot(region, &snapshot) == 0) {
+            display_snapshot(&renderer, &snapshot);
+            shown++;
+            if (!snapshot.dc_running) {
+                break;  // DC has exited, nothing more will be published
+            }
+        } else {
+            printf("histo-view: Waiting for DC to publish a snapshot...\n");
+        }
+        if (refreshes == 0 || shown < refreshes) {
+            nanosleep(&interval, NULL);
+        }
+    }
+
+    // Clean up
+    renderer_free(&renderer);
+    detach_snapshot_region(region);
+    return EXIT_SUCCESS;
+}
@@ -7,17 +7,133 @@
  * This header file declares the functions used to manage a circular buffer within the shared memory.
  * It includes functionality for writing and reading single or multiple characters while respecting
  * the buffer boundaries and synchronization with semaphores.
+ * Every producer has its own lane, and each function takes the lane it works on; DC reads
+ * all lanes fairly with bulk_read_from_lanes.
+ * The buffer operations themselves are lock-free (single-producer, single-consumer). In
+ * RING_MODE_SEMAPHORE the callers additionally wrap them in ring_lock/ring_unlock, which
+ * keeps the old semaphore-guarded behaviour available for comparison.
+ * wait_for_data lets DC sleep on a futex until a producer fills the ring past
+ * shm->wake_threshold, instead of polling on a timer. write_with_policy is what the
+ * producers call: it takes the semaphore itself (so a blocked producer never holds it),
+ * applies the producer's overflow policy and keeps its counters in shared memory.
+ * write_in_place and consume_from_lanes are the zero-copy versions: producers generate letters
+ * directly in reserved ring slots and DC counts them where they lie (ring_reserve/ring_commit and
+ * ring_peek/ring_release underneath).
+ * In RING_FORMAT_RECORDS the lanes carry framed event records instead of raw symbols: each
+ * record is a record_header_t (length, key, timestamp) followed by an optional payload, padded
+ * to RECORD_ALIGN bytes. A record never wraps; when it does not fit before the end of the lane,
+ * the producer writes a padding marker and the record starts again at offset 0. Producers
+ * enqueue a batch with write_records and DC dequeues many records per call with
+ * read_records_from_lanes, which copies them into a record_batch_t.
+ * In RING_FORMAT_PACKED (A-T build only) the lanes carry 64-bit words of PACKED_PER_WORD 5-bit
+ * letters (see common.h), so the same segment holds 1.5 times as many letters and DC pulls that
+ * many fewer cache lines across cores. write_with_policy and write_in_place encode the letters on
+ * the way in, and DC counts the words where they lie with consume_packed_from_lanes. Only whole
+ * words are published: a producer carries the letters of a partial word over to its next write,
+ * and ring_flush pads and publishes them when it stops.
+ * consume_from_lane_set and consume_packed_from_lane_set do the same over every stride-th lane
+ * only, for a DC that splits the lanes between several consumer threads.
  */
 #ifndef CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_H
 
 #include "shared_memory.h"
+#include "common.h"
+#include <time.h>
 
-/* Functions */
-int get_available_space(shared_memory_t *shm);
-int write_to_buffer(shared_memory_t *shm, char letter);
-int read_from_buffer(shared_memory_t *shm, char *letter);
-int bulk_write_to_buffer(shared_memory_t *shm, char *letters, int count);
-int bulk_read_from_buffer(shared_memory_t *shm, char *letters, int count);
+/* Ring slots handed out by ring_reserve or ring_peek: first piece, then the piece after the wrap */
+typedef struct {
+    symbol_t *first;   /* Slots from the index to at most the end of the lane */
+    int first_count;
+    symbol_t *second;  /* Slots from the start of the lane, second_count may be 0 */
+    int second_count;
+} ring_span_t;
 
-#endif /* CIRCULAR_BUFFER_H */
\ No newline at end of file
+typedef void (*ring_fill_t)(symbol_t *letters, int count);             /* Generates letters in place */
+typedef void (*ring_consume_t)(const symbol_t *letters, int count);    /* Counts letters in place */
+typedef void (*ring_consume_packed_t)(const uint64_t *words, int count); /* Counts packed words in place */
+
+/* Record framing (RING_FORMAT_RECORDS) */
+#define RECORD_ALIGN 8                 /* Records start at multiples of this many bytes */
+#define RECORD_PADDING 0x80000000u     /* Set in a length word: skip the rest of the lane */
+#define RECORD_MAX_PAYLOAD 4096        /* Largest payload a producer may attach */
+#define RECORD_BATCH_MAX 1024          /* Records returned by one batched dequeue */
+#define RECORD_BATCH_BYTES (64 * 1024) /* Payload bytes returned by one batched dequeue */
+
+/* Record header as stored in the lane, directly followed by the payload */
+typedef struct {
+    uint32_t length;        /* Header plus payload bytes, before alignment (or RECORD_PADDING | skip) */
+    uint32_t key;           /* Histogram field, a bin number 0..LETTER_RANGE-1 */
+    uint64_t timestamp_ns;  /* CLOCK_MONOTONIC time the producer created the event */
+} record_header_t;
+
+/* One event, as handed to write_records or returned by read_records */
+typedef struct {
+    uint32_t key;             /* Histogram bin */
+    uint32_t payload_length;  /* Bytes at payload, 0 for none */
+    uint64_t timestamp_ns;    /* Producer's CLOCK_MONOTONIC timestamp */
+    const void *payload;      /* Payload bytes (inside the batch after a read) */
+} record_t;
+
+/* Destination of a batched dequeue; payloads are copied into data */
+typedef struct {
+    int count;                               /* Records in records[] */
+    size_t used;                             /* Bytes of data[] holding payloads */
+    record_t records[RECORD_BATCH_MAX];
+    unsigned char data[RECORD_BATCH_BYTES];
+} record_batch_t;
+
+/* Functions (per lane) */
+int get_available_space(shared_memory_t *shm, int lane);
+int write_to_buffer(shared_memory_t *shm, int lane, symbol_t letter);
+int read_from_buffer(shared_memory_t *shm, int lane, symbol_t *letter);
+int bulk_write_to_buffer(shared_memory_t *shm, int lane, symbol_t *letters, int count);
+int bulk_read_from_buffer(shared_memory_t *shm, int lane, symbol_t *letters, int count);
+int write_with_policy(shared_memory_t *shm, int semid, int lane, symbol_t *letters, int count);
+int write_in_place(shared_memory_t *shm, int semid, int lane, ring_fill_t fill, int count);
+void ring_flush(shared_memory_t *shm, int semid, int lane);
+
+/* Zero-copy access (per lane) */
+int ring_reserve(shared_memory_t *shm, int lane, int count, ring_span_t *span);
+void ring_commit(shared_memory_t *shm, int lane, int count);
+int ring_peek(shared_memory_t *shm, int lane, int count, ring_span_t *span);
+int ring_release(shared_memory_t *shm, int lane, int count);
+int get_used_space(shared_memory_t *shm, int lane);
+
+/* Framed records (RING_FORMAT_RECORDS) */
+int write_records(shared_memory_t *shm, int semid, int lane, const record_t *records, int count);
+int read_records(shared_memory_t *shm, int lane, record_batch_t *batch, int max_records);
+int read_records_from_lanes(shared_memory_t *shm, int *next_lane, record_batch_t *batch, int max_records);
+int write_letters_as_records(shared_memory_t *shm, int semid, int lane, const symbol_t *letters, int count,
+                             int max_payload);
+int record_payload_from_env(const shared_memory_t *shm);
+uint64_t lane_capacity(const shared_memory_t *shm);
+const char *ring_unit_name(int ring_format);
+
+/* Packed letters (RING_FORMAT_PACKED) */
+int consume_packed_from_lanes(shared_memory_t *shm, int *next_lane, int count, ring_consume_packed_t consume);
+int consume_packed_from_lane_set(shared_memory_t *shm, int first, int stride, int *next_lane, int count,
+                                 ring_consume_packed_t consume);
+
+/* Consumer side, across all lanes */
+int bulk_read_from_lanes(shared_memory_t *shm, int *next_lane, symbol_t *letters, int count);
+int consume_from_lanes(shared_memory_t *shm, int *next_lane, int count, ring_consume_t consume);
+
+/* Consumer side, one thread's share of the lanes: first, first + stride, ... */
+int consume_from_lane_set(shared_memory_t *shm, int first, int stride, int *next_lane, int count,
+                          ring_consume_t consume);
+long get_total_used_space(shared_memory_t *shm);
+int wait_for_data(shared_memory_t *shm, const struct timespec *timeout);
+
+/* Ring mode helpers */
+void ring_lock(shared_memory_t *shm, int semid);
+void ring_unlock(shared_memory_t *shm, int semid);
+void ring_track_lock_wait(_Atomic uint64_t *counter);
+int parse_ring_mode(const char *name);
+const char *ring_mode_name(int ring_mode);
+int parse_overflow_policy(const char *name);
+const char *overflow_policy_name(int policy);
+int parse_ring_format(const char *name);
+const char *ring_format_name(int ring_format);
+
+#endif /* CIRCULAR_BUFFER_H */
@@ -5,17 +5,75 @@
  * FIRST VERSION: 08-04-2025
  * DESCRIPTION:
  * This file contains global constants and utility functions that are common to all components.
- * It defines valid letter boundaries and includes a helper function to generate random letters.
+ * It defines valid letter boundaries and includes helper functions to generate random letters.
+ * Letters come from a per-process xoshiro256** generator with unbiased range reduction; the batch
+ * version extracts several letters from every 64-bit draw.
+ * The symbol domain is defined here and nowhere else. It is fixed at build time with
+ * make SYMBOLS=20|256|65536 (-DSYMBOL_DOMAIN): the default is the letters A-T, 256 covers every
+ * byte value and 65536 every 16-bit key. symbol_t is the ring element type for the chosen domain,
+ * and every histogram, window and snapshot array is sized from LETTER_RANGE, so each build is
+ * specialized for its domain with no runtime cost.
  */
 #ifndef COMMON_H
 #define COMMON_H
 
-/* Constants */
+#include <stdint.h>
+
+/* Symbol domain */
+#ifndef SYMBOL_DOMAIN
+#define SYMBOL_DOMAIN 20
+#endif
+
+#if SYMBOL_DOMAIN == 20
+typedef char symbol_t;           /* Letters A-T, one byte each (the original alphabet) */
 #define MIN_LETTER 'A'
 #define MAX_LETTER 'T'
-#define LETTER_RANGE (MAX_LETTER - MIN_LETTER + 1)
+#define SYMBOL_FORMAT "%c"
+#elif SYMBOL_DOMAIN == 256
+typedef unsigned char symbol_t;  /* Every byte value */
+#define MIN_LETTER 0
+#define MAX_LETTER 255
+#define SYMBOL_FORMAT "%02X"
+#elif SYMBOL_DOMAIN == 65536
+typedef uint16_t symbol_t;       /* 16-bit keys */
+#define MIN_LETTER 0
+#define MAX_LETTER 65535
+#define SYMBOL_FORMAT "%04X"
+#else
+#error "SYMBOL_DOMAIN must be 20, 256 or 65536"
+#endif
+
+/* Constants */
+#define LETTER_RANGE (MAX_LETTER - MIN_LETTER + 1)  /* Histogram bins */
+
+/* Packed form: symbols stored as their bin in the fewest bits the domain needs, low bits first in
+   64-bit words (A-T needs 5 bits, so 12 symbols share a word; the wider domains pack 8 and 4) */
+#if LETTER_RANGE <= 32
+#define PACKED_SYMBOL_BITS 5
+#elif LETTER_RANGE <= 256
+#define PACKED_SYMBOL_BITS 8
+#else
+#define PACKED_SYMBOL_BITS 16
+#endif
+#define PACKED_PER_WORD (64 / PACKED_SYMBOL_BITS)
+#define PACKED_MASK ((1ULL << PACKED_SYMBOL_BITS) - 1)
+#define PACKED_WORDS(count) (((count) + PACKED_PER_WORD - 1) / PACKED_PER_WORD)
+/* The unused fields of a partly filled word hold PACKED_PAD, which is only free (not a bin) when
+   the domain leaves a field value over: the packed ring format needs that, so it is A-T only */
+#define PACKED_PAD PACKED_MASK
+#define PACKED_RING_SUPPORTED (LETTER_RANGE <= PACKED_PAD)
+
+/* Random letter generation functions */
+void init_random(uint64_t seed);
+uint64_t seed_from_env(const char *name, int stream);
+symbol_t generate_random_letter(void);
+void generate_random_letters(symbol_t *letters, int count);
+
+/* Symbol display */
+int format_symbol(char *text, int size, int bin);
 
-/* Random letter generation function */
-char generate_random_letter(void);
+/* Packed form */
+int pack_letters(const symbol_t *letters, int count, uint64_t *words);
+int unpack_letters(const uint64_t *words, int word_count, symbol_t *letters);
 
-#endif /* COMMON_H */
\ No newline at end of file
+#endif /* COMMON_H */
@@ -0,0 +1,23 @@
+/*
+ * FILE: futex_utils.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header provides thin wrappers around the Linux futex syscall. A futex word lives in
+ * shared memory, so any attached process can sleep on it or wake the processes sleeping on it.
+ * They are used to wake DC when producers publish data without a syscall on the fast path.
+ * REFERENCES:
+ * https://man7.org/linux/man-pages/man2/futex.2.html
+ */
+#ifndef FUTEX_UTILS_H
+#define FUTEX_UTILS_H
+
+#include <stdatomic.h>
+#include <time.h>
+
+/* Functions */
+int futex_wait(atomic_uint *word, unsigned int expected, const struct timespec *timeout);
+void futex_wake(atomic_uint *word);
+
+#endif /* FUTEX_UTILS_H */
@@ -0,0 +1,55 @@
+/*
+ * FILE: histogram_kernel.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the letter counting kernel used by DC to turn large batches of letters
+ * into histogram counts. The scalar kernel spreads consecutive letters over several
+ * sub-histograms so repeated hits on one bin do not wait on each other's stores; on x86 an
+ * SSE2 or AVX2 kernel compares 16 or 32 letters per instruction against every bin. The fastest
+ * kernel the CPU supports is picked at runtime unless one is chosen by name.
+ * The SIMD kernels only exist for one-byte symbol domains small enough to keep one counter
+ * vector per bin (the default A-T build); wider domains always count with the scalar kernel.
+ * count_packed_letters counts symbols still in the packed form of common.h (letter logs), taking
+ * every field of a word straight to its bin without unpacking to symbols first. A caller counting
+ * many small runs (the blocks of a log) keeps a packed_counter_t instead, so the sub-histograms are
+ * cleared and merged once for all of them rather than once per run.
+ */
+#ifndef HISTOGRAM_KERNEL_H
+#define HISTOGRAM_KERNEL_H
+
+#include "common.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* Packed counting: in the 5-bit domain a field is a pair of symbols, counted with one increment */
+#if PACKED_SYMBOL_BITS == 5
+#define PACKED_FIELD_SYMBOLS 2
+#else
+#define PACKED_FIELD_SYMBOLS 1
+#endif
+#define PACKED_FIELD_BITS (PACKED_SYMBOL_BITS * PACKED_FIELD_SYMBOLS)
+#define PACKED_SUB_HISTOGRAMS 4
+#if PACKED_SYMBOL_BITS == 16
+#define PACKED_TABLE_SIZE 1  /* 16-bit fields are counted straight into the histogram */
+#else
+#define PACKED_TABLE_SIZE (1 << PACKED_FIELD_BITS)
+#endif
+
+/* Sub-histograms collecting the whole packed words of several count calls until they are merged */
+typedef struct {
+    uint32_t sub[PACKED_SUB_HISTOGRAMS][PACKED_TABLE_SIZE];
+    size_t pending;  /* Symbols collected since the last merge */
+} packed_counter_t;
+
+/* Functions */
+size_t count_letters(const symbol_t *letters, size_t count, uint64_t *counts);
+size_t count_packed_letters(const uint64_t *words, size_t count, uint64_t *counts);
+void packed_counter_init(packed_counter_t *counter);
+size_t packed_counter_add(packed_counter_t *counter, const uint64_t *words, size_t count, uint64_t *counts);
+size_t packed_counter_merge(packed_counter_t *counter, uint64_t *counts);
+int select_count_kernel(const char *name);
+const char *count_kernel_name(void);
+
+#endif /* HISTOGRAM_KERNEL_H */
@@ -0,0 +1,49 @@
+/*
+ * FILE: histogram_render.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the histogram renderer. A frame (one row per letter plus a scale legend)
+ * is built in a buffer allocated once at startup and sent with a single write. On a terminal
+ * only the rows that changed since the last frame are redrawn, using cursor addressing.
+ * Bars are drawn in one of three modes: classic (* = 100, + = 10, - = 1, cut off at
+ * RENDER_MAX_BAR), log or auto (linear), where the largest count always fills the bar width.
+ * Domains wider than RENDER_MAX_ROWS bins (see common.h) are drawn with neighbouring bins summed
+ * into one row, labelled with the first and last symbol of the row.
+ */
+#ifndef HISTOGRAM_RENDER_H
+#define HISTOGRAM_RENDER_H
+
+#include <stdint.h>
+
+/* Bar modes */
+#define BAR_MODE_CLASSIC 0  /* Original hundreds/tens/ones bars */
+#define BAR_MODE_LOG 1      /* Length proportional to log(count), largest count = full width */
+#define BAR_MODE_AUTO 2     /* Length proportional to count, largest count = full width */
+
+/* Constants */
+#define RENDER_DEFAULT_WIDTH 60  /* Bar width in the log and auto modes */
+#define RENDER_MAX_BAR 200       /* Longest bar in any mode, classic bars are cut off here */
+#define RENDER_MAX_ROWS 32       /* Histogram rows on screen, wider domains are grouped */
+
+/* Renderer state, owned by the process that displays the histogram */
+typedef struct {
+    int fd;            /* Where frames are written */
+    int bar_mode;      /* BAR_MODE_* */
+    int width;         /* Bar width for the log and auto modes */
+    int rows;          /* Histogram rows plus the legend */
+    int use_cursor;    /* fd is a terminal: redraw changed rows in place */
+    int screen_valid;  /* The terminal still shows our last frame */
+    char *frame;       /* Frame buffer, filled and written once per render */
+    char *screen;      /* Rows as last drawn, rows * RENDER_ROW_SIZE */
+} histogram_renderer_t;
+
+/* Functions */
+int renderer_init(histogram_renderer_t *renderer, int fd, int bar_mode, int width);
+void renderer_free(histogram_renderer_t *renderer);
+void renderer_invalidate(histogram_renderer_t *renderer);
+int render_histogram(histogram_renderer_t *renderer, const uint64_t *counts);
+int parse_bar_mode(const char *name);
+
+#endif /* HISTOGRAM_RENDER_H */
@@ -0,0 +1,37 @@
+/*
+ * FILE: latency_histogram.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the HDR-style latency histogram DC uses for enqueue-to-count latency.
+ * Values below LATENCY_SUB_BUCKETS nanoseconds get a bucket each; above that, every power of two
+ * is split into LATENCY_SUB_BUCKETS / 2 equal buckets, so any latency up to 2^64 ns is kept with
+ * at most 1 / (LATENCY_SUB_BUCKETS / 2) relative error in a fixed, small array. Recording is
+ * one count-leading-zeros and one increment; percentiles walk the buckets.
+ */
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+/* Constants */
+#define LATENCY_SUB_BUCKET_BITS 7                            /* 128 linear buckets, < 1.6% error above them */
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS + (64 - LATENCY_SUB_BUCKET_BITS) * (LATENCY_SUB_BUCKETS / 2))
+
+/* Log-bucketed histogram of nanosecond values */
+typedef struct {
+    uint64_t counts[LATENCY_BUCKETS];  /* Values per bucket */
+    uint64_t total;                    /* Values recorded */
+    uint64_t sum;                      /* Sum of the values, for the mean */
+    uint64_t max;                      /* Largest value, exact */
+} latency_histogram_t;
+
+/* Functions */
+void latency_reset(latency_histogram_t *histogram);
+void latency_record(latency_histogram_t *histogram, uint64_t value);
+uint64_t latency_percentile(const latency_histogram_t *histogram, double percentile);
+double latency_mean(const latency_histogram_t *histogram);
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,81 @@
+/*
+ * FILE: letter_log.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the letter log, a compact append-only recording of a letter stream that
+ * DC writes (-w) and DP-2 replays (-P). Symbols are stored as their offset from MIN_LETTER in the
+ * fewest bits the domain needs, packed into 64-bit words: A-T needs 5 bits, so 12 letters share a
+ * word; the byte and 16-bit domains pack 8 and 4. The stream is cut into blocks of at most
+ * LETTER_LOG_BLOCK_LETTERS letters, closed at least every LETTER_LOG_TICK_NS, and every block
+ * starts with the wall-clock offset of its first letter from the start of the log, so a replay can
+ * reproduce the original timing to within a tick.
+ * File layout: letter_log_header_t, then blocks of { letter_log_block_header_t, packed words }.
+ */
+#ifndef LETTER_LOG_H
+#define LETTER_LOG_H
+
+#include "common.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/* File identification */
+#define LETTER_LOG_MAGIC 0x474f4c48u  /* "HLOG" */
+#define LETTER_LOG_VERSION 1
+
+/* Packing: the packed form of common.h */
+#define LETTER_LOG_BITS PACKED_SYMBOL_BITS
+#define LETTER_LOG_PER_WORD PACKED_PER_WORD
+#define LETTER_LOG_MASK PACKED_MASK
+
+/* Blocking */
+#define LETTER_LOG_BLOCK_LETTERS 4096  /* Most letters in one block */
+#define LETTER_LOG_TICK_NS 10000000LL  /* A block is closed once its first letter is this old (10 ms) */
+#define LETTER_LOG_BLOCK_WORDS ((LETTER_LOG_BLOCK_LETTERS + LETTER_LOG_PER_WORD - 1) / LETTER_LOG_PER_WORD)
+
+/* File header, written once when the log is created */
+typedef struct {
+    uint32_t magic;            /* LETTER_LOG_MAGIC */
+    uint32_t version;          /* LETTER_LOG_VERSION */
+    uint32_t symbol_bins;      /* LETTER_RANGE of the recording binary */
+    uint32_t bits_per_symbol;  /* LETTER_LOG_BITS of the recording binary */
+    int64_t start_unix_ns;     /* CLOCK_REALTIME when the log was created, block offsets count from here */
+} letter_log_header_t;
+
+/* Block header, followed by (count + LETTER_LOG_PER_WORD - 1) / LETTER_LOG_PER_WORD packed words */
+typedef struct {
+    int64_t offset_ns;  /* Time of the block's first letter since start_unix_ns */
+    uint32_t count;     /* Letters in the block, 1..LETTER_LOG_BLOCK_LETTERS */
+    uint32_t reserved;  /* Zero */
+} letter_log_block_header_t;
+
+/* Recording side */
+typedef struct {
+    FILE *file;
+    int64_t start_unix_ns;     /* From the file header */
+    int64_t block_offset_ns;   /* Offset of the first pending letter */
+    int pending_count;         /* Letters waiting to be written as a block */
+    symbol_t pending[LETTER_LOG_BLOCK_LETTERS];
+    uint64_t letters;          /* Letters recorded by this writer */
+    uint64_t bytes;            /* Bytes appended by this writer */
+} letter_log_writer_t;
+
+/* Replay side: one unpacked block at a time */
+typedef struct {
+    FILE *file;
+    letter_log_header_t header;
+    int64_t offset_ns;          /* Offset of the block just read */
+    int count;                  /* Letters in it */
+    symbol_t letters[LETTER_LOG_BLOCK_LETTERS];
+} letter_log_reader_t;
+
+/* Functions */
+int letter_log_create(letter_log_writer_t *writer, const char *path);
+void letter_log_append(letter_log_writer_t *writer, const symbol_t *letters, int count);
+void letter_log_close(letter_log_writer_t *writer);
+int letter_log_open(letter_log_reader_t *reader, const char *path);
+int letter_log_next(letter_log_reader_t *reader);
+void letter_log_close_reader(letter_log_reader_t *reader);
+
+#endif /* LETTER_LOG_H */
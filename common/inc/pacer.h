@@ -0,0 +1,43 @@
+/*
+ * FILE: pacer.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the pacing engine used by the producers. A pacer sleeps with
+ * clock_nanosleep(TIMER_ABSTIME) until absolute CLOCK_MONOTONIC deadlines, so time spent
+ * generating and writing letters never accumulates as drift, and hands out letters from a
+ * token bucket refilled at the target rate. Slow rates tick once per batch; rates too fast
+ * for one batch per PACER_MIN_TICK_NS switch to one tick per PACER_MIN_TICK_NS, emitting
+ * however many letters the bucket holds, so rates from 1/s to millions/s are reachable.
+ */
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* Constants */
+#define PACER_MIN_TICK_NS 1000000L  /* Shortest sleep between emissions (1 ms) */
+#define PACER_MAX_LAG_TICKS 8       /* Ticks we may fall behind before the backlog is abandoned */
+
+/* Pacer state, owned by one producer */
+typedef struct {
+    double rate;             /* Target letters per second */
+    int64_t tick_ns;         /* Time between deadlines */
+    double tokens_per_tick;  /* rate * tick, letters earned per deadline */
+    double tokens;           /* Earned but not yet emitted, carries the fractional part */
+    int max_emit;            /* Most letters a single tick can hand out */
+    struct timespec start;   /* When pacing started */
+    struct timespec next;    /* Next absolute deadline */
+    uint64_t emitted;        /* Letters handed out so far */
+    uint64_t skipped_ticks;  /* Deadlines abandoned because we fell too far behind */
+} pacer_t;
+
+/* Functions */
+int pacer_init(pacer_t *pacer, double rate, int batch_size);
+int pacer_wait(pacer_t *pacer);
+int64_t pacer_elapsed_ns(const pacer_t *pacer);
+double pacer_achieved_rate(const pacer_t *pacer);
+
+#endif /* PACER_H */
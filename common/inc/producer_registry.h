@@ -0,0 +1,26 @@
+/*
+ * FILE: producer_registry.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the producer registry kept in shared memory. Every producer claims a
+ * slot (and with it the lane of the same number) when it starts and marks it exited when it
+ * stops, so DC can find, stop and account for any number of producers without being given
+ * their PIDs on the command line. Producers also publish their pacer's progress here so DC can
+ * show achieved against target rate.
+ */
+#ifndef PRODUCER_REGISTRY_H
+#define PRODUCER_REGISTRY_H
+
+#include "shared_memory.h"
+
+/* Functions */
+int register_producer(shared_memory_t *shm, int policy, int batch_size, double rate);
+void unregister_producer(shared_memory_t *shm, int slot);
+void record_producer_pacing(shared_memory_t *shm, int slot, uint64_t emitted, int64_t elapsed_ns);
+double producer_achieved_rate(const producer_slot_t *producer);
+int count_active_producers(shared_memory_t *shm);
+void signal_producers(shared_memory_t *shm, int signum);
+
+#endif /* PRODUCER_REGISTRY_H */
@@ -0,0 +1,46 @@
+/*
+ * FILE: ring_stats.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the runtime statistics kept in the shared segment. Each process only
+ * writes its own cache line: producers their registry slot (letters written, dropped, overwritten,
+ * time blocked and time waiting for the semaphore), DC the consumer block (letters read, read
+ * passes, wakeups, time of the last read pass and semaphore wait). Counters are relaxed atomic
+ * stores by their single owner, so updating them costs no more than a plain add. collect_ring_stats
+ * folds everything, plus the lanes' occupancy, into one totals struct for monitors like histo-stat.
+ */
+#ifndef RING_STATS_H
+#define RING_STATS_H
+
+#include "shared_memory.h"
+
+/* Totals over every producer and lane at one instant; units are letters, or records and bytes in record format */
+typedef struct {
+    uint64_t taken_ns;          /* CLOCK_MONOTONIC time of the collection */
+    uint64_t written;           /* Published by the producers */
+    uint64_t dropped;           /* Discarded newest, ring full */
+    uint64_t overwritten;       /* Discarded oldest, ring full */
+    uint64_t blocked_ns;        /* Producers waiting for space */
+    uint64_t producer_lock_ns;  /* Producers waiting for the semaphore */
+    uint64_t consumed;          /* Read by DC */
+    uint64_t drains;            /* DC read passes */
+    uint64_t wakeups;           /* DC futex wakeups */
+    uint64_t consumer_lock_ns;  /* DC waiting for the semaphore */
+    uint64_t last_drain_ns;     /* CLOCK_MONOTONIC time of DC's last read pass, 0 if none */
+    uint64_t used;              /* Unread letters (record bytes) in every lane */
+    uint64_t capacity;          /* Letters (record bytes) every lane together can hold */
+    int active_producers;       /* Producers still running */
+    int consumer_attached;      /* A DC is consuming */
+} ring_stats_t;
+
+/* Functions */
+uint64_t monotonic_ns(void);
+void consumer_stats_attach(shared_memory_t *shm);
+void consumer_stats_detach(shared_memory_t *shm);
+void consumer_stats_drain(shared_memory_t *shm, int consumed);
+void consumer_stats_wakeup(shared_memory_t *shm);
+void collect_ring_stats(const shared_memory_t *shm, ring_stats_t *stats);
+
+#endif /* RING_STATS_H */
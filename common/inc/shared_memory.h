@@ -7,8 +7,17 @@
  * This header defines the structure of the shared memory used for inter-process communication.
  * It includes buffer size constants and functions to create, attach, detach, and initialize
  * the shared memory, along with its read/write indices.
+ * Each producer owns one single-producer/single-consumer lane, so producers never synchronize
+ * with each other. A lane's indices are free-running 64-bit C11 atomics kept on separate cache
+ * lines so its producer and the consumer can exchange data without a lock (see circular_buffer.h
+ * for the ring modes). The segment starts with a header recording the lane capacity, lane count,
+ * layout version and symbol domain, followed by a flexible data region sized at runtime by DP-1. The capacity
+ * is a power of two so an index is turned into a lane position with & header.mask.
+ * A futex word lets DC sleep until a producer fills its lane past a threshold, and a per-lane one
+ * lets a producer with the blocking overflow policy sleep until DC frees space.
  * REFERENCES:
  * https://www.tutorialspoint.com/inter_process_communication/inter_process_communication_shared_memory.htm
+ * https://en.cppreference.com/w/c/atomic
  */
  #ifndef SHARED_MEMORY_H
 #define SHARED_MEMORY_H
@@ -16,24 +25,122 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
 
 /* Constants */
-#define BUFFER_SIZE 256
+#define DEFAULT_BUFFER_SIZE (64UL * 1024)          /* 64 Ki symbols per lane unless DP-1 is told otherwise */
+#define MIN_BUFFER_SIZE (1UL * 1024)               /* 1 KiB */
+#define MAX_BUFFER_SIZE (16UL * 1024 * 1024 * 1024) /* 16 GiB */
 #define SHM_KEY 9876  /* Arbitrary key for shared memory */
 #define SEM_KEY 5432  /* Arbitrary key for semaphore */
+#define CACHE_LINE_SIZE 64  /* Keeps producer and consumer fields from false sharing */
+
+/* Segment header identification */
+#define SHM_MAGIC 0x48495354u     /* "HIST" */
+#define SHM_LAYOUT_VERSION 9      /* Bump whenever shared_memory_t changes */
+
+/* Ring synchronization modes */
+#define RING_MODE_LOCKFREE 0   /* C11 atomics only, no syscalls in the uncontended case */
+#define RING_MODE_SEMAPHORE 1  /* Every access guarded by the SysV semaphore (fallback) */
+
+/* Ring formats, what the lanes carry */
+#define RING_FORMAT_SYMBOLS 0  /* One symbol_t per slot (original behaviour), indices count symbols */
+#define RING_FORMAT_RECORDS 1  /* Length-prefixed event records, indices count bytes */
+#define RING_FORMAT_PACKED 2   /* PACKED_PER_WORD symbols per 64-bit word (A-T build), indices count words */
+
+/* Producer registry (see producer_registry.h) */
+#define MAX_PRODUCERS 64      /* Also the maximum number of lanes */
+#define DEFAULT_LANE_COUNT 2  /* DP-1 and DP-2 */
+#define SLOT_FREE 0           /* Slot never claimed */
+#define SLOT_ACTIVE 1         /* Producer running and writing its lane */
+#define SLOT_EXITED 2         /* Producer gone, counters kept for accounting */
+
+/* Overflow policies, applied by a producer when the ring is full */
+#define OVERFLOW_DROP_NEWEST 0  /* Discard the letters that do not fit (original behaviour) */
+#define OVERFLOW_BLOCK 1        /* Wait until DC frees enough space */
+#define OVERFLOW_OVERWRITE 2    /* Discard the oldest unread letters to make room */
+
+/* Segment header, stamped once by the creator and checked by every process that attaches */
+typedef struct {
+    uint32_t magic;         /* SHM_MAGIC */
+    uint32_t version;       /* SHM_LAYOUT_VERSION */
+    uint64_t capacity;      /* Capacity of each lane in symbols, a power of two */
+    uint64_t mask;          /* capacity - 1, replaces % capacity on the hot path */
+    uint32_t lane_count;    /* Number of lanes in use (1..MAX_PRODUCERS) */
+    uint32_t symbol_bins;   /* LETTER_RANGE of the creating binary, all processes must agree */
+    uint64_t data_offset;   /* offsetof(shared_memory_t, buffer) in the creating binary */
+    uint64_t segment_size;  /* data_offset + lane_count * capacity * sizeof(symbol_t) */
+} shm_header_t;
+
+/* Producer registry slot, one cache line per producer; counters are only written by their owner */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_int state;  /* SLOT_FREE, SLOT_ACTIVE or SLOT_EXITED */
+    pid_t pid;                       /* Producer process, signalled by DC on shutdown */
+    int policy;                      /* OVERFLOW_DROP_NEWEST, OVERFLOW_BLOCK or OVERFLOW_OVERWRITE */
+    int batch_size;                  /* Letters per write */
+    double rate;                     /* Target letters per second */
+    _Atomic uint64_t written;        /* Letters published into the ring */
+    _Atomic uint64_t dropped;        /* Newest letters discarded because the ring was full */
+    _Atomic uint64_t overwritten;    /* Oldest unread letters discarded to make room */
+    _Atomic uint64_t blocked_ns;     /* Time spent waiting for space */
+    _Atomic uint64_t emitted;        /* Letters released by the producer's pacer */
+    _Atomic uint64_t paced_ns;       /* Time the pacer has been running, emitted / paced_ns = achieved rate */
+    _Atomic uint64_t lock_wait_ns;   /* Time spent waiting for the semaphore (semaphore mode only) */
+} producer_slot_t;
+
+/* Consumer statistics, one cache line written only by DC (see ring_stats.h) */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_int attached;  /* Set while a DC is consuming */
+    pid_t pid;                       /* DC process */
+    _Atomic uint64_t consumed;       /* Letters (records) read from the ring */
+    _Atomic uint64_t drains;         /* Read passes that returned, full or not */
+    _Atomic uint64_t wakeups;        /* Futex wakeups from the producers */
+    _Atomic uint64_t last_drain_ns;  /* CLOCK_MONOTONIC time of the last read pass */
+    _Atomic uint64_t lock_wait_ns;   /* Time spent waiting for the semaphore (semaphore mode only) */
+} consumer_stats_t;
+
+/* Single-producer/single-consumer lane indices; lane i's data starts at symbol i * capacity of buffer */
+typedef struct {
+    /* Producer cache line: written by the lane's producer, read by DC */
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t write_index;  /* Published end of data, DC reads up to here */
+    uint64_t cached_read_index;    /* Producer's last seen copy of read_index */
+    atomic_uint space_futex;       /* Bumped by DC after reading while the producer waits for space */
+    atomic_uint producer_waiting;  /* Set by an OVERFLOW_BLOCK producer while it is (about to be) asleep */
+
+    /* Consumer cache line: written by DC (and by an overwriting producer), read by the producer */
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t read_index;  /* Index where DC reads from */
+    uint64_t cached_write_index;   /* DC's last seen copy of write_index */
+} ring_lane_t;
 
 /* Shared memory structure */
 typedef struct {
-    char buffer[BUFFER_SIZE];  /* Circular buffer to hold letters A-T */
-    int read_index;            /* Index where DC reads from */
-    int write_index;           /* Index where DPs write to */
+    /* Read-mostly header and configuration, set once by DP-1 */
+    shm_header_t header;
+    int ring_mode;    /* RING_MODE_LOCKFREE or RING_MODE_SEMAPHORE */
+    int ring_format;  /* RING_FORMAT_SYMBOLS, RING_FORMAT_RECORDS or RING_FORMAT_PACKED */
+
+    /* Wakeup cache line: DC sleeps on data_futex while every lane holds less than wake_threshold */
+    _Alignas(CACHE_LINE_SIZE) atomic_uint data_futex;  /* Bumped by the producer that crosses the threshold */
+    atomic_uint consumer_waiting;  /* Set by DC while it is (about to be) asleep */
+    uint64_t wake_threshold;       /* Fill level that wakes DC, 1 = empty to non-empty */
+
+    producer_slot_t producers[MAX_PRODUCERS];  /* Producer registry, slot i writes lane i */
+    consumer_stats_t consumer;                 /* DC's counters, next to the producers' */
+    ring_lane_t lanes[MAX_PRODUCERS];          /* One lane per producer, same index */
+
+    _Alignas(CACHE_LINE_SIZE) char buffer[];  /* Lane data regions, capacity symbol_t slots each */
 } shared_memory_t;
 
 /* Functions */
-int create_shared_memory();
+int create_shared_memory(uint64_t capacity, int lane_count);
 int attach_shared_memory(int shmid, shared_memory_t **shm);
-void detach_shared_memory(shared_memory_t *shm);
+int attach_shared_memory_readonly(int shmid, const shared_memory_t **shm);
+void detach_shared_memory(const shared_memory_t *shm);
 void remove_shared_memory(int shmid);
-void init_shared_memory(shared_memory_t *shm);
+void init_shared_memory(shared_memory_t *shm, int ring_mode, int ring_format);
+size_t shm_segment_size(uint64_t capacity, int lane_count);
+int parse_buffer_size(const char *text, uint64_t *capacity);
 
-#endif /* SHARED_MEMORY_H */
\ No newline at end of file
+#endif /* SHARED_MEMORY_H */
@@ -0,0 +1,48 @@
+/*
+ * FILE: sliding_window.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header declares the rolling-window histograms. Letters are counted into the current
+ * one-second bucket; once a second the bucket is closed into a ring of the last WINDOW_BUCKETS
+ * buckets, and each window's running sums gain the new bucket and lose the one that just slid
+ * out of it, so the cost per second is the same however long the windows are.
+ * Every bucket holds LETTER_RANGE counters, so the 16-bit domain build closes a bucket every ten
+ * seconds instead of every second; its 10-second window is then a single bucket.
+ */
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include "common.h"
+#include <stdint.h>
+
+/* Constants */
+#if LETTER_RANGE > 256
+#define WINDOW_BUCKET_SECONDS 10  /* 16-bit domain: coarser buckets keep the ring at 30 x 512 KiB */
+#else
+#define WINDOW_BUCKET_SECONDS 1   /* Length of one bucket */
+#endif
+#define WINDOW_BUCKETS (300 / WINDOW_BUCKET_SECONDS)  /* Buckets kept, enough for the longest window (5 minutes) */
+#define WINDOW_COUNT 3           /* 10 seconds, 1 minute, 5 minutes */
+
+/* Rolling windows over per-second letter counts */
+typedef struct {
+    uint64_t buckets[WINDOW_BUCKETS][LETTER_RANGE];  /* Ring of closed buckets, head is the next to reuse */
+    uint64_t current[LETTER_RANGE];                  /* Bucket being filled */
+    uint64_t sums[WINDOW_COUNT][LETTER_RANGE];       /* Letters in each window's closed buckets */
+    int lengths[WINDOW_COUNT];                       /* Window lengths in buckets */
+    int head;                                        /* Ring position of the next closed bucket */
+    uint64_t closed;                                 /* Buckets closed so far */
+} window_set_t;
+
+/* Functions */
+void windows_init(window_set_t *windows);
+void windows_add(window_set_t *windows, const uint64_t *counts);
+void windows_rotate(window_set_t *windows);
+int window_seconds(const window_set_t *windows, int window);
+uint64_t window_total(const window_set_t *windows, int window);
+double window_rate(const window_set_t *windows, int window, int letter);
+const char *window_name(int window);
+
+#endif /* SLIDING_WINDOW_H */
@@ -0,0 +1,71 @@
+/*
+ * FILE: snapshot.h
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This header defines the histogram snapshot region: a small shared-memory segment of its own
+ * (SNAPSHOT_KEY) where DC publishes its counts, rolling-window totals and ring statistics for
+ * monitoring tools. DC is the only writer and publishes under a seqlock: the sequence number is
+ * odd while a snapshot is being written, and a reader retries if the sequence was odd or changed
+ * while it copied. Readers attach read-only and never write anything, so any number of them can
+ * watch without locks, syscalls or any effect on DC.
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "shared_memory.h"
+#include "sliding_window.h"
+#include "common.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Constants */
+#define SNAPSHOT_KEY 9877            /* Arbitrary key for the snapshot segment */
+#define SNAPSHOT_MAGIC 0x534E4150u   /* "SNAP" */
+#define SNAPSHOT_VERSION 3           /* Bump whenever histogram_snapshot_t changes */
+#define SNAPSHOT_READ_RETRIES 1000   /* Torn reads tolerated before read_snapshot gives up */
+
+/* One consistent view of DC's state, copied out whole by readers */
+typedef struct {
+    uint64_t publish_count;                               /* Snapshots published so far */
+    uint64_t timestamp_ns;                                /* CLOCK_REALTIME when published */
+    pid_t dc_pid;                                         /* Publishing DC */
+    int dc_running;                                       /* 0 in the final snapshot */
+    uint64_t counts[LETTER_RANGE];                        /* All-time letter counts */
+    uint64_t window_counts[WINDOW_COUNT][LETTER_RANGE];   /* Letters per rolling window */
+    int window_seconds[WINDOW_COUNT];                     /* Time each window currently covers */
+    uint64_t wakeups;                                     /* DC data wakeups so far */
+    uint64_t latency_count;                               /* Records with a latency (record format only) */
+    uint64_t latency_p50_ns;                              /* Enqueue-to-count latency percentiles */
+    uint64_t latency_p99_ns;
+    uint64_t latency_p999_ns;
+    uint64_t latency_max_ns;
+    uint64_t capacity;                                    /* Lane size: symbols, record bytes or packed words */
+    int ring_format;                                      /* RING_FORMAT_SYMBOLS, RING_FORMAT_RECORDS or RING_FORMAT_PACKED */
+    int lane_count;                                       /* Lanes in the ring */
+    int active_producers;                                 /* Producers still registered */
+    uint64_t lane_used[MAX_PRODUCERS];                    /* Unread data per lane, in the unit of capacity */
+    uint64_t written;                                     /* Sum of the producers' counters (records or letters) */
+    uint64_t dropped;
+    uint64_t overwritten;
+} histogram_snapshot_t;
+
+/* The shared segment: header, seqlock and the snapshot it protects */
+typedef struct {
+    uint32_t magic;                                     /* SNAPSHOT_MAGIC */
+    uint32_t version;                                   /* SNAPSHOT_VERSION */
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t sequence;  /* Odd while DC is writing */
+    histogram_snapshot_t snapshot;
+} snapshot_region_t;
+
+/* Functions */
+int create_snapshot_region(snapshot_region_t **region);
+int attach_snapshot_region(const snapshot_region_t **region);
+void detach_snapshot_region(const snapshot_region_t *region);
+void remove_snapshot_region(int shmid);
+void publish_snapshot(snapshot_region_t *region, const histogram_snapshot_t *snapshot);
+int read_snapshot(const snapshot_region_t *region, histogram_snapshot_t *snapshot);
+
+#endif /* SNAPSHOT_H */
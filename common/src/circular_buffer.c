@@ -7,112 +7,1504 @@
  * This file implements the logic for interacting with a circular buffer
  * stored in shared memory. It supports both single and bulk read/write
  * operations while managing buffer space and avoiding overflow.
+ * The segment holds one single-producer/single-consumer lane per producer. A producer
+ * copies its letters into its lane and publishes them by storing write_index; DC reads
+ * up to write_index and releases space by moving read_index. Each side keeps a cached
+ * copy of the other side's index and only touches the other cache line when the cached
+ * copy says the lane is full/empty. No two producers ever touch the same cache line.
+ * write_with_policy applies a producer's overflow policy when its lane is full: drop the
+ * newest letters, block until DC frees space, or overwrite the oldest unread letters. An
+ * overwriting producer moves read_index itself, so DC releases space with a compare-and-swap
+ * and re-reads if its copy was overtaken.
+ * The zero-copy pairs work on the ring slots directly: ring_reserve/ring_commit let a producer
+ * fill slots in place (write_in_place does this with its overflow policy), and ring_peek/
+ * ring_release let DC count letters where they lie (consume_from_lanes). Slots are described as a
+ * ring_span_t, two pieces when they cross the wrap point. Lanes written with the overwrite policy
+ * are still copied out first, since their producer may reclaim peeked slots.
+ * Bulk transfers are copied with memcpy in at most two contiguous segments (before and
+ * after the wrap point) and published with a single index store. DC multiplexes the lanes
+ * with bulk_read_from_lanes, which visits them round-robin with a per-lane quota.
+ * Slots hold one symbol_t each (a byte, or two bytes in the 16-bit domain build), and every
+ * index, capacity and count in this file is in symbols.
+ * The record functions further down use the same lanes, indices and wakeups, but treat a lane
+ * as capacity * sizeof(symbol_t) bytes and count their indices in bytes. A record is written
+ * in place and published with one write_index store per batch; DC copies every complete
+ * record up to write_index and releases them with one read_index store. Records cannot be
+ * overwritten (DC could be reading half of one), so producers in record format drop or block.
+ * The packed functions treat a lane as capacity * sizeof(symbol_t) / 8 words and count their
+ * indices in words. Producers stage a batch behind the letters carried over from their last
+ * write, pack the whole words and copy them in, carrying the rest to the next write; only
+ * ring_flush pads a last word with PACKED_PAD. DC counts them in place and releases whole words. Like
+ * records, packed words are counted in place and never overwritten: producers drop or block.
  */
+#define _POSIX_C_SOURCE 200809L  // Enables clock_gettime
+
 #include "../inc/circular_buffer.h"
+#include "../inc/semaphore_utils.h"
+#include "../inc/futex_utils.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A blocked producer re-checks for space at least this often (ns), even without a wakeup */
+#define BLOCK_RECHECK_NS 100000000L
+/* Letters copied out per step for lanes that cannot be consumed in place */
+#define CONSUME_COPY_BATCH 1024
+/* Words a packed producer encodes per step */
+#define PACKED_STAGE_WORDS 256
+
+/* Letters a packed producer holds back until they fill a word, per lane this process writes */
+static symbol_t packed_carry[MAX_PRODUCERS][PACKED_PER_WORD];
+static int packed_carry_count[MAX_PRODUCERS];
+
+/* This process's semaphore wait counter in the segment, set by ring_track_lock_wait (shared by all its threads) */
+static _Atomic uint64_t *lock_wait_counter = NULL;
+
+/*
+ * Name    : clamp_count
+ * Purpose : Convert a slot count to the int used by the buffer API
+ * Input   : Slot count (a huge value means a stale, already overtaken index)
+ * Outputs : None
+ * Returns : The count, limited to 0..INT_MAX
+ */
+static inline int clamp_count(uint64_t slots) {
+    if (slots > (uint64_t)INT64_MAX) {
+        return 0;
+    }
+    return (slots > INT_MAX) ? INT_MAX : (int)slots;
+}
+
+/*
+ * Name    : lane_data
+ * Purpose : Locate a lane's data region in this process's mapping of the segment
+ * Input   : Pointer to shared memory, lane number
+ * Outputs : None
+ * Returns : Pointer to the first slot of the lane
+ */
+static inline symbol_t *lane_data(shared_memory_t *shm, int lane) {
+    return (symbol_t *)shm->buffer + (size_t)lane * (size_t)shm->header.capacity;
+}
+
+/*
+ * Name    : copy_into_ring
+ * Purpose : Copy letters into a lane starting at a free-running index, splitting at the wrap point
+ * Input   : Pointer to shared memory, lane number, start index, source letters, number of letters (<= capacity)
+ * Outputs : Lane slots filled
+ * Returns : None
+ */
+static void copy_into_ring(shared_memory_t *shm, int lane, uint64_t index, const symbol_t *letters, int count) {
+    symbol_t *data = lane_data(shm, lane);
+    uint64_t pos = index & shm->header.mask;
+    uint64_t first = shm->header.capacity - pos;
+
+    if (first > (uint64_t)count) {
+        first = (uint64_t)count;
+    }
+    memcpy(&data[pos], letters, (size_t)first * sizeof(symbol_t));
+    memcpy(data, letters + first, ((size_t)count - (size_t)first) * sizeof(symbol_t));
+}
+
+/*
+ * Name    : copy_from_ring
+ * Purpose : Copy letters out of a lane starting at a free-running index, splitting at the wrap point
+ * Input   : Pointer to shared memory, lane number, start index, destination array, number of letters (<= capacity)
+ * Outputs : Destination array filled
+ * Returns : None
+ */
+static void copy_from_ring(shared_memory_t *shm, int lane, uint64_t index, symbol_t *letters, int count) {
+    const symbol_t *data = lane_data(shm, lane);
+    uint64_t pos = index & shm->header.mask;
+    uint64_t first = shm->header.capacity - pos;
+
+    if (first > (uint64_t)count) {
+        first = (uint64_t)count;
+    }
+    memcpy(letters, &data[pos], (size_t)first * sizeof(symbol_t));
+    memcpy(letters + first, data, ((size_t)count - (size_t)first) * sizeof(symbol_t));
+}
+
+/*
+ * Name    : notify_consumer
+ * Purpose : Wake DC if this publish moved the lane from below to at/above the wake threshold
+ * Input   : Pointer to shared memory, lane, write index before and after the publish
+ * Outputs : DC woken when it is asleep and the threshold was crossed
+ * Returns : None
+ */
+static void notify_consumer(shared_memory_t *shm, ring_lane_t *lane, uint64_t before, uint64_t after) {
+    uint64_t read_idx;
+
+    /* Pairs with the fence in wait_for_data: either DC sees our data or we see it waiting */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!atomic_load_explicit(&shm->consumer_waiting, memory_order_relaxed)) {
+        return;  /* DC is awake, no syscall needed */
+    }
+
+    read_idx = atomic_load_explicit(&lane->read_index, memory_order_relaxed);
+    if (before - read_idx < shm->wake_threshold && after - read_idx >= shm->wake_threshold) {
+        atomic_fetch_add_explicit(&shm->data_futex, 1, memory_order_release);
+        futex_wake(&shm->data_futex);
+    }
+}
+
+/*
+ * Name    : notify_producer
+ * Purpose : Wake a lane's producer blocked on a full lane after DC has freed space
+ * Input   : Lane
+ * Outputs : Blocked producer woken, if any
+ * Returns : None
+ */
+static void notify_producer(ring_lane_t *lane) {
+    /* Pairs with the fence in write_with_policy: either it sees the space or we see it waiting */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&lane->producer_waiting, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&lane->space_futex, 1, memory_order_release);
+        futex_wake(&lane->space_futex);
+    }
+}
+
+/*
+ * Name    : counter_add
+ * Purpose : Add to a counter that only the calling process writes (no atomic read-modify-write needed)
+ * Input   : Counter, amount
+ * Outputs : Counter updated
+ * Returns : None
+ */
+static inline void counter_add(_Atomic uint64_t *counter, uint64_t amount) {
+    if (amount != 0) {
+        atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                              memory_order_relaxed);
+    }
+}
 
 /*
  * Name    : get_available_space
- * Purpose : Calculate how much space is left in the circular buffer
- * Input   : Pointer to shared memory buffer
+ * Purpose : Calculate how much space is left in a lane
+ * Input   : Pointer to shared memory buffer, lane number
  * Outputs : None
  * Returns : Number of available spaces
  */
-int get_available_space(shared_memory_t *shm) {
-    int read_idx = shm->read_index;
-    int write_idx = shm->write_index;
-    
-    if (read_idx <= write_idx) {
-        /* Read index is before or at write index */
-        return BUFFER_SIZE - (write_idx - read_idx) - 1;
-    } else {
-        /* Write index has wrapped around */
-        return read_idx - write_idx - 1;
-    }
+int get_available_space(shared_memory_t *shm, int lane) {
+    uint64_t read_idx = atomic_load_explicit(&shm->lanes[lane].read_index, memory_order_acquire);
+    uint64_t write_idx = atomic_load_explicit(&shm->lanes[lane].write_index, memory_order_relaxed);
+
+    /* Indices are free-running, so the difference is the number of used slots */
+    return clamp_count(shm->header.capacity - (write_idx - read_idx));
 }
+
 /*
 * Name    : write_to_buffer
-* Purpose : Write a single character to the buffer if space is available
-* Input   : Pointer to shared memory, letter to write
+* Purpose : Write a single character to a lane if space is available
+* Input   : Pointer to shared memory, lane number, letter to write
 * Outputs : Updated buffer
 * Returns : 1 if success, 0 if buffer is full
 */
-int write_to_buffer(shared_memory_t *shm, char letter) {
-    int next_write = (shm->write_index + 1) % BUFFER_SIZE;
-    
-    /* Check if buffer is full */
-    if (next_write == shm->read_index) {
-        return 0;  /* Buffer full */
-    }
-    
-    /* Write letter and update write index */
-    shm->buffer[shm->write_index] = letter;
-    shm->write_index = next_write;
-    
-    return 1;
+int write_to_buffer(shared_memory_t *shm, int lane, symbol_t letter) {
+    return bulk_write_to_buffer(shm, lane, &letter, 1);
 }
 
 
 /*
  * Name    : read_from_buffer
- * Purpose : Read a single character from the buffer if data is available
- * Input   : Pointer to shared memory, pointer to output letter
+ * Purpose : Read a single character from a lane if data is available
+ * Input   : Pointer to shared memory, lane number, pointer to output letter
  * Outputs : The character read
  * Returns : 1 if success, 0 if buffer is empty
  */
-int read_from_buffer(shared_memory_t *shm, char *letter) {
-    /* Check if buffer is empty */
-    if (shm->read_index == shm->write_index) {
-        return 0;  /* Buffer empty */
+int read_from_buffer(shared_memory_t *shm, int lane, symbol_t *letter) {
+    return bulk_read_from_buffer(shm, lane, letter, 1);
+}
+
+/*
+ * Name    : discard_oldest
+ * Purpose : Make room for a producer by moving read_index past the oldest letters of its lane
+ * Input   : Lane, read index the caller saw, letters wanted
+ * Outputs : read_index advanced (DC notices through its compare-and-swap and re-reads)
+ * Returns : Number of letters discarded (0 if DC moved read_index first)
+ */
+static uint64_t discard_oldest(ring_lane_t *lane, uint64_t read_idx, uint64_t wanted) {
+    if (!atomic_compare_exchange_strong_explicit(&lane->read_index, &read_idx, read_idx + wanted,
+                                                 memory_order_acq_rel, memory_order_relaxed)) {
+        return 0;
     }
-    
-    /* Read letter and update read index */
-    *letter = shm->buffer[shm->read_index];
-    shm->read_index = (shm->read_index + 1) % BUFFER_SIZE;
-    
-    return 1;
+    lane->cached_read_index = read_idx + wanted;
+    return wanted;
+}
+
+/*
+ * Name    : reserve_slots
+ * Purpose : Find room for letters at the end of a lane, optionally discarding the oldest letters
+ * Input   : Pointer to shared memory, lane number, number of letters wanted, overwrite flag,
+ *           pointer to a count of discarded letters (only used when overwriting)
+ * Outputs : Producer's cached read index refreshed when needed
+ * Returns : Number of free slots from write_index on, at most count
+ */
+static int reserve_slots(shared_memory_t *shm, int lane_no, int count, int overwrite, uint64_t *overwritten) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    /* Only this lane's producer moves write_index, so it does not need to be re-read atomically */
+    uint64_t head = atomic_load_explicit(&lane->write_index, memory_order_relaxed);
+    uint64_t read_idx = lane->cached_read_index;
+    int available = clamp_count(shm->header.capacity - (head - read_idx));
+
+    if (count <= 0) {
+        return 0;
+    }
+
+    if (available < count) {
+        /* Cached copy looks too full, refresh it from the consumer's cache line */
+        read_idx = atomic_load_explicit(&lane->read_index, memory_order_acquire);
+        lane->cached_read_index = read_idx;
+        available = clamp_count(shm->header.capacity - (head - read_idx));
+
+        while (available < count && overwrite) {
+            uint64_t wanted = (uint64_t)count - (uint64_t)available;
+            uint64_t discarded;
+
+            if (wanted > head - read_idx) {
+                wanted = head - read_idx;  /* Cannot discard more than the lane holds */
+            }
+            discarded = discard_oldest(lane, read_idx, wanted);
+            *overwritten += discarded;
+            if (discarded == wanted) {
+                available += (int)discarded;
+                break;
+            }
+            /* DC read concurrently, look again */
+            read_idx = atomic_load_explicit(&lane->read_index, memory_order_acquire);
+            lane->cached_read_index = read_idx;
+            available = clamp_count(shm->header.capacity - (head - read_idx));
+        }
+    }
+
+    return (count <= available) ? count : available;
+}
+
+/*
+ * Name    : lane_span
+ * Purpose : Describe count slots of a lane from an index as at most two contiguous pieces
+ * Input   : Pointer to shared memory, lane number, start index, number of slots (<= capacity), span
+ * Outputs : span filled (second piece empty unless the slots wrap)
+ * Returns : None
+ */
+static void lane_span(shared_memory_t *shm, int lane_no, uint64_t index, int count, ring_span_t *span) {
+    symbol_t *data = lane_data(shm, lane_no);
+    uint64_t pos = index & shm->header.mask;
+    uint64_t first = shm->header.capacity - pos;
+
+    span->first = &data[pos];
+    span->first_count = ((uint64_t)count <= first) ? count : (int)first;
+    span->second = data;
+    span->second_count = count - span->first_count;
+}
+
+/*
+ * Name    : ring_reserve
+ * Purpose : Zero-copy write, step 1: hand out free slots of a lane to be filled in place
+ * Input   : Pointer to shared memory, lane number, number of letters wanted, span
+ * Outputs : span points at the reserved slots inside the ring (two pieces across the wrap point)
+ * Returns : Number of slots reserved, less than count (possibly 0) when the lane is that full
+ */
+int ring_reserve(shared_memory_t *shm, int lane, int count, ring_span_t *span) {
+    int reserved = reserve_slots(shm, lane, count, 0, NULL);
+
+    lane_span(shm, lane, atomic_load_explicit(&shm->lanes[lane].write_index, memory_order_relaxed), reserved, span);
+    return reserved;
+}
+
+/*
+ * Name    : ring_commit
+ * Purpose : Zero-copy write, step 2: publish filled slots with a single store
+ * Input   : Pointer to shared memory, lane number, number of slots filled (at most the number reserved)
+ * Outputs : write_index advanced, DC woken if the lane crossed the wake threshold
+ * Returns : None
+ */
+void ring_commit(shared_memory_t *shm, int lane_no, int count) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    uint64_t head = atomic_load_explicit(&lane->write_index, memory_order_relaxed);
+
+    if (count > 0) {
+        atomic_store_explicit(&lane->write_index, head + (uint64_t)count, memory_order_release);
+        notify_consumer(shm, lane, head, head + (uint64_t)count);
+    }
+}
+
+/*
+ * Name    : ring_write
+ * Purpose : Put letters into a lane and publish them, optionally discarding the oldest letters.
+ *           The letters are copied from an array, or generated in place when letters is NULL.
+ * Input   : Pointer to shared memory, lane number, letter array (or NULL), fill function (used when
+ *           letters is NULL), number of letters, overwrite flag, pointer to a count of discarded
+ *           letters (only used when overwriting)
+ * Outputs : Updated buffer
+ * Returns : Number of letters actually written
+ */
+static int ring_write(shared_memory_t *shm, int lane_no, const symbol_t *letters, ring_fill_t fill, int count,
+                      int overwrite, uint64_t *overwritten) {
+    uint64_t head = atomic_load_explicit(&shm->lanes[lane_no].write_index, memory_order_relaxed);
+    int to_write = reserve_slots(shm, lane_no, count, overwrite, overwritten);
+    ring_span_t span;
+
+    if (to_write <= 0) {
+        return 0;  /* Buffer full */
+    }
+
+    /* Fill the free slots and publish them with a single store */
+    if (letters != NULL) {
+        copy_into_ring(shm, lane_no, head, letters, to_write);
+    } else {
+        lane_span(shm, lane_no, head, to_write, &span);
+        fill(span.first, span.first_count);
+        if (span.second_count > 0) {
+            fill(span.second, span.second_count);
+        }
+    }
+    ring_commit(shm, lane_no, to_write);
+
+    return to_write;
 }
 
 /*
  * Name    : bulk_write_to_buffer
- * Purpose : Write multiple letters into the buffer
- * Input   : Pointer to shared memory, letter array, number of letters
+ * Purpose : Write multiple letters into a lane
+ * Input   : Pointer to shared memory, lane number, letter array, number of letters
  * Outputs : Updated buffer
  * Returns : Number of letters actually written
  */
-int bulk_write_to_buffer(shared_memory_t *shm, char *letters, int count) {
-    int available = get_available_space(shm);
-    int to_write = (count <= available) ? count : available;
-    int written = 0;
-    
-    for (int i = 0; i < to_write; i++) {
-        if (write_to_buffer(shm, letters[i])) {
-            written++;
-        } else {
+int bulk_write_to_buffer(shared_memory_t *shm, int lane, symbol_t *letters, int count) {
+    return ring_write(shm, lane, letters, NULL, count, 0, NULL);
+}
+
+/*
+ * Name    : packed_write
+ * Purpose : Copy as many packed words as fit into a lane and publish them with a single store
+ * Input   : Pointer to shared memory, lane number, words, number of words
+ * Outputs : Updated lane
+ * Returns : Number of words written
+ */
+static int packed_write(shared_memory_t *shm, int lane_no, const uint64_t *words, int count) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    uint64_t *data = (uint64_t *)lane_data(shm, lane_no);
+    uint64_t size = lane_capacity(shm);
+    uint64_t head = atomic_load_explicit(&lane->write_index, memory_order_relaxed);
+    uint64_t pos = head & (size - 1);
+    uint64_t available = size - (head - lane->cached_read_index);
+    uint64_t first;
+
+    if (available < (uint64_t)count) {
+        /* Cached copy looks too full, refresh it from the consumer's cache line */
+        lane->cached_read_index = atomic_load_explicit(&lane->read_index, memory_order_acquire);
+        available = size - (head - lane->cached_read_index);
+    }
+    if (available < (uint64_t)count) {
+        count = (int)available;
+    }
+    if (count <= 0) {
+        return 0;  /* Lane full */
+    }
+
+    first = size - pos;
+    if (first > (uint64_t)count) {
+        first = (uint64_t)count;
+    }
+    memcpy(&data[pos], words, (size_t)first * sizeof(uint64_t));
+    memcpy(data, words + first, ((size_t)count - (size_t)first) * sizeof(uint64_t));
+    atomic_store_explicit(&lane->write_index, head + (uint64_t)count, memory_order_release);
+    notify_consumer(shm, lane, head, head + (uint64_t)count);
+    return count;
+}
+
+/*
+ * Name    : packed_publish
+ * Purpose : Write packed words into a producer's lane, blocking for space under OVERFLOW_BLOCK
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number, words, number of words,
+ *           time spent blocked (added to)
+ * Outputs : Updated lane; may block (OVERFLOW_BLOCK)
+ * Returns : Number of words written (fewer when the lane is full and the rest must be dropped)
+ */
+static int packed_publish(shared_memory_t *shm, int semid, int lane, const uint64_t *words, int word_count,
+                          uint64_t *blocked_ns) {
+    ring_lane_t *ring = &shm->lanes[lane];
+    int words_written;
+
+    ring_lock(shm, semid);
+    words_written = packed_write(shm, lane, words, word_count);
+    ring_unlock(shm, semid);
+
+    if (words_written < word_count && shm->producers[lane].policy == OVERFLOW_BLOCK) {
+        struct timespec start;
+        struct timespec end;
+        struct timespec timeout = { 0, BLOCK_RECHECK_NS };
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (words_written < word_count) {
+            unsigned int seq = atomic_load_explicit(&ring->space_futex, memory_order_acquire);
+            uint64_t head = atomic_load_explicit(&ring->write_index, memory_order_relaxed);
+            int interrupted = 0;
+
+            /* Announce that we are going to sleep before the final check, so no wakeup is lost */
+            atomic_store_explicit(&ring->producer_waiting, 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (head - atomic_load_explicit(&ring->read_index, memory_order_acquire) >= lane_capacity(shm)) {
+                interrupted = (futex_wait(&ring->space_futex, seq, &timeout) == -1 && errno == EINTR);
+            }
+            atomic_store_explicit(&ring->producer_waiting, 0, memory_order_relaxed);
+
+            ring_lock(shm, semid);
+            words_written += packed_write(shm, lane, words + words_written, word_count - words_written);
+            ring_unlock(shm, semid);
+
+            if (interrupted) {
+                break;  /* Let the caller see its stop flag; the rest is counted as dropped */
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        *blocked_ns += (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL + (uint64_t)end.tv_nsec -
+                       (uint64_t)start.tv_nsec;
+    }
+    return words_written;
+}
+
+/*
+ * Name    : packed_policy_write
+ * Purpose : policy_write for RING_FORMAT_PACKED: pack the lane's carried letters and the new ones a
+ *           stage at a time and write the whole words, dropping or blocking when the lane is full
+ *           (overwrite is treated as drop); fewer than PACKED_PER_WORD letters are carried to the
+ *           next call unless flush is set, which pads them into a last word
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number, letter array (or NULL to
+ *           generate with fill), fill function, number of letters, flush flag
+ * Outputs : Updated lane, carry and producer counters (in letters, counted when published or
+ *           dropped); may block (OVERFLOW_BLOCK)
+ * Returns : Number of the new letters not dropped (written or carried)
+ */
+static int packed_policy_write(shared_memory_t *shm, int semid, int lane, const symbol_t *letters, ring_fill_t fill,
+                               int count, int flush) {
+    producer_slot_t *producer = &shm->producers[lane];
+    symbol_t stage[PACKED_STAGE_WORDS * PACKED_PER_WORD];
+    uint64_t words[PACKED_STAGE_WORDS];
+    uint64_t blocked_ns = 0;
+    int carried = packed_carry_count[lane];
+    int staged = carried;
+    int taken = 0;
+    int published = 0;
+    int dropped = 0;
+
+    memcpy(stage, packed_carry[lane], (size_t)carried * sizeof(symbol_t));
+    while (taken < count || (flush && staged > 0)) {
+        int take = (count - taken < PACKED_STAGE_WORDS * PACKED_PER_WORD - staged)
+                       ? count - taken
+                       : PACKED_STAGE_WORDS * PACKED_PER_WORD - staged;
+        int ready;
+        int word_count;
+        int words_written;
+
+        if (take > 0) {
+            if (letters != NULL) {
+                memcpy(stage + staged, letters + taken, (size_t)take * sizeof(symbol_t));
+            } else {
+                fill(stage + staged, take);
+            }
+            staged += take;
+            taken += take;
+        }
+
+        /* Whole words only, unless this is the flush of the last letters */
+        ready = (flush && taken == count) ? staged : staged - staged % PACKED_PER_WORD;
+        if (ready == 0) {
+            break;
+        }
+        word_count = pack_letters(stage, ready, words);
+        words_written = packed_publish(shm, semid, lane, words, word_count, &blocked_ns);
+
+        if (words_written < word_count) {
+            /* Lane full: the rest of the batch, carried letters included, is dropped */
+            published += words_written * PACKED_PER_WORD;
+            dropped += staged - words_written * PACKED_PER_WORD + (count - taken);
+            taken = count;
+            staged = 0;
             break;
         }
+        published += ready;
+        staged -= ready;
+        memmove(stage, stage + ready, (size_t)staged * sizeof(symbol_t));
+    }
+
+    memcpy(packed_carry[lane], stage, (size_t)staged * sizeof(symbol_t));
+    packed_carry_count[lane] = staged;
+
+    counter_add(&producer->blocked_ns, blocked_ns);
+    counter_add(&producer->written, (uint64_t)published);
+    counter_add(&producer->dropped, (uint64_t)dropped);
+
+    /* Words are published oldest first, so carried letters are the first to be dropped */
+    return count - ((dropped > carried) ? dropped - carried : 0);
+}
+
+/*
+ * Name    : policy_write
+ * Purpose : Write letters into a producer's lane, applying its overflow policy and updating its counters
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number, letter array (or NULL to
+ *           generate in place with fill), fill function, number of letters
+ * Outputs : Updated buffer and producer counters; may block (OVERFLOW_BLOCK) until DC frees space
+ * Returns : Number of letters actually written (less than count only when letters were dropped)
+ */
+static int policy_write(shared_memory_t *shm, int semid, int lane, const symbol_t *letters, ring_fill_t fill,
+                        int count) {
+    producer_slot_t *producer = &shm->producers[lane];
+    uint64_t overwritten = 0;
+    int overwrite = (producer->policy == OVERFLOW_OVERWRITE);
+    int written;
+
+    if (shm->ring_format == RING_FORMAT_PACKED) {
+        return packed_policy_write(shm, semid, lane, letters, fill, count, 0);
+    }
+
+    ring_lock(shm, semid);
+    written = ring_write(shm, lane, letters, fill, count, overwrite, &overwritten);
+    ring_unlock(shm, semid);
+
+    if (written < count && producer->policy == OVERFLOW_BLOCK) {
+        ring_lane_t *ring = &shm->lanes[lane];
+        struct timespec start;
+        struct timespec end;
+        struct timespec timeout = { 0, BLOCK_RECHECK_NS };
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (written < count) {
+            unsigned int seq = atomic_load_explicit(&ring->space_futex, memory_order_acquire);
+            int interrupted = 0;
+
+            /* Announce that we are going to sleep before the final check, so no wakeup is lost */
+            atomic_store_explicit(&ring->producer_waiting, 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (get_available_space(shm, lane) == 0) {
+                interrupted = (futex_wait(&ring->space_futex, seq, &timeout) == -1 && errno == EINTR);
+            }
+            atomic_store_explicit(&ring->producer_waiting, 0, memory_order_relaxed);
+
+            ring_lock(shm, semid);
+            written += ring_write(shm, lane, (letters != NULL) ? letters + written : NULL, fill, count - written, 0,
+                                  NULL);
+            ring_unlock(shm, semid);
+
+            if (interrupted) {
+                break;  /* Let the caller see its stop flag; the rest is counted as dropped */
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        counter_add(&producer->blocked_ns, (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL +
+                                           (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec);
     }
-    
+
+    counter_add(&producer->written, (uint64_t)written);
+    counter_add(&producer->dropped, (uint64_t)(count - written));
+    counter_add(&producer->overwritten, overwritten);
+
     return written;
 }
 
+/*
+ * Name    : write_with_policy
+ * Purpose : Copy letters into a producer's lane, applying its overflow policy and updating its counters
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number, letter array, number of letters
+ * Outputs : Updated buffer and producer counters; may block (OVERFLOW_BLOCK) until DC frees space
+ * Returns : Number of letters actually written (less than count only when letters were dropped)
+ */
+int write_with_policy(shared_memory_t *shm, int semid, int lane, symbol_t *letters, int count) {
+    return policy_write(shm, semid, lane, letters, NULL, count);
+}
+
+/*
+ * Name    : write_in_place
+ * Purpose : Like write_with_policy, but the letters are generated straight into the reserved
+ *           ring slots by fill (e.g. generate_random_letters) instead of being copied in
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number, fill function, number of letters
+ * Outputs : Updated buffer and producer counters; may block (OVERFLOW_BLOCK) until DC frees space
+ * Returns : Number of letters actually written (less than count only when letters were dropped)
+ */
+int write_in_place(shared_memory_t *shm, int semid, int lane, ring_fill_t fill, int count) {
+    return policy_write(shm, semid, lane, NULL, fill, count);
+}
+
+/*
+ * Name    : ring_flush
+ * Purpose : Publish the letters a producer still holds back: in packed format, the carried letters
+ *           padded into a last word (nothing to do in the other formats). Producers call it before
+ *           they unregister
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number
+ * Outputs : Updated lane and producer counters; may block (OVERFLOW_BLOCK)
+ * Returns : None
+ */
+void ring_flush(shared_memory_t *shm, int semid, int lane) {
+    if (shm->ring_format == RING_FORMAT_PACKED) {
+        (void)packed_policy_write(shm, semid, lane, NULL, NULL, 0, 1);
+    }
+}
 
 /*
  * Name    : bulk_read_from_buffer
- * Purpose : Read multiple letters from the buffer
- * Input   : Pointer to shared memory, letter array, max number to read
+ * Purpose : Read multiple letters from a lane
+ * Input   : Pointer to shared memory, lane number, letter array, max number to read
  * Outputs : Letter array filled with read data
  * Returns : Number of letters read
  */
-int bulk_read_from_buffer(shared_memory_t *shm, char *letters, int count) {
-    int read_count = 0;
-    
-    for (int i = 0; i < count; i++) {
-        if (read_from_buffer(shm, &letters[i])) {
-            read_count++;
-        } else {
+int bulk_read_from_buffer(shared_memory_t *shm, int lane_no, symbol_t *letters, int count) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    uint64_t tail = atomic_load_explicit(&lane->read_index, memory_order_acquire);
+    uint64_t write_idx;
+    int available;
+    int read_count;
+
+    for (;;) {
+        write_idx = lane->cached_write_index;
+        available = clamp_count(write_idx - tail);
+
+        if (available < count) {
+            /* Cached copy looks too empty, refresh it from the producer's cache line */
+            write_idx = atomic_load_explicit(&lane->write_index, memory_order_acquire);
+            lane->cached_write_index = write_idx;
+            available = clamp_count(write_idx - tail);
+        }
+
+        read_count = (count <= available) ? count : available;
+        if (read_count <= 0) {
+            return 0;  /* Buffer empty */
+        }
+
+        copy_from_ring(shm, lane_no, tail, letters, read_count);
+
+        /* Hand the slots back to the producer; if it overwrote them (moving read_index)
+           while we were copying, the copy may be torn and is read again from the new index */
+        if (atomic_compare_exchange_strong_explicit(&lane->read_index, &tail, tail + (uint64_t)read_count,
+                                                    memory_order_acq_rel, memory_order_acquire)) {
             break;
         }
     }
-    
+    notify_producer(lane);
+
     return read_count;
-}
\ No newline at end of file
+}
+
+/*
+ * Name    : bulk_read_from_lanes
+ * Purpose : Read letters from every lane, fairly: each visit takes at most an equal share of
+ *           count, starting from a lane that rotates between calls, then leftover room is
+ *           offered to lanes with more data
+ * Input   : Pointer to shared memory, rotating start lane (updated), letter array, max number to read
+ * Outputs : Letter array filled with read data
+ * Returns : Number of letters read
+ */
+int bulk_read_from_lanes(shared_memory_t *shm, int *next_lane, symbol_t *letters, int count) {
+    int lane_count = (int)shm->header.lane_count;
+    int quota = (count / lane_count > 0) ? count / lane_count : 1;
+    int total = 0;
+
+    for (int pass = 0; pass < 2 && total < count; pass++) {
+        for (int i = 0; i < lane_count && total < count; i++) {
+            int lane = (*next_lane + i) % lane_count;
+            int wanted = count - total;
+
+            if (pass == 0 && wanted > quota) {
+                wanted = quota;
+            }
+            total += bulk_read_from_buffer(shm, lane, letters + total, wanted);
+        }
+    }
+    *next_lane = (*next_lane + 1) % lane_count;
+
+    return total;
+}
+
+/*
+ * Name    : lane_capacity
+ * Purpose : Size of one lane in the unit its indices count
+ * Input   : Pointer to shared memory
+ * Outputs : None
+ * Returns : Capacity in symbols, in bytes in RING_FORMAT_RECORDS or in words in RING_FORMAT_PACKED
+ */
+uint64_t lane_capacity(const shared_memory_t *shm) {
+    if (shm->ring_format == RING_FORMAT_RECORDS) {
+        return shm->header.capacity * sizeof(symbol_t);
+    }
+    if (shm->ring_format == RING_FORMAT_PACKED) {
+        return shm->header.capacity * sizeof(symbol_t) / sizeof(uint64_t);
+    }
+    return shm->header.capacity;
+}
+
+/*
+ * Name    : ring_unit_name
+ * Purpose : Name of the unit lane indices and capacities count in a ring format
+ * Input   : Ring format constant
+ * Outputs : None
+ * Returns : "symbols", "bytes" or "words"
+ */
+const char *ring_unit_name(int ring_format) {
+    if (ring_format == RING_FORMAT_RECORDS) {
+        return "bytes";
+    }
+    return (ring_format == RING_FORMAT_PACKED) ? "words" : "symbols";
+}
+
+/*
+ * Name    : record_size
+ * Purpose : Bytes a record takes in the lane
+ * Input   : Payload length
+ * Outputs : None
+ * Returns : Header plus payload, rounded up to RECORD_ALIGN
+ */
+static inline uint64_t record_size(uint32_t payload_length) {
+    return ((uint64_t)sizeof(record_header_t) + payload_length + RECORD_ALIGN - 1) & ~(uint64_t)(RECORD_ALIGN - 1);
+}
+
+/*
+ * Name    : record_space
+ * Purpose : Bytes a record needs at a write position, including padding to skip past the wrap point
+ * Input   : Lane size in bytes, write index, record size
+ * Outputs : None
+ * Returns : Bytes needed
+ */
+static inline uint64_t record_space(uint64_t size, uint64_t head, uint64_t bytes) {
+    uint64_t to_end = size - (head & (size - 1));
+
+    return (to_end < bytes) ? to_end + bytes : bytes;
+}
+
+/*
+ * Name    : record_write
+ * Purpose : Frame as many records as fit into a lane and publish them with a single store
+ * Input   : Pointer to shared memory, lane number, records, number of records
+ * Outputs : Updated lane
+ * Returns : Number of records written
+ */
+static int record_write(shared_memory_t *shm, int lane_no, const record_t *records, int count) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    unsigned char *data = (unsigned char *)lane_data(shm, lane_no);
+    uint64_t size = lane_capacity(shm);
+    uint64_t start = atomic_load_explicit(&lane->write_index, memory_order_relaxed);
+    uint64_t head = start;
+    int written = 0;
+
+    for (; written < count; written++) {
+        const record_t *record = &records[written];
+        uint64_t bytes = record_size(record->payload_length);
+        uint64_t needed = record_space(size, head, bytes);
+        record_header_t header;
+
+        if (size - (head - lane->cached_read_index) < needed) {
+            /* Cached copy looks too full, refresh it from the consumer's cache line */
+            lane->cached_read_index = atomic_load_explicit(&lane->read_index, memory_order_acquire);
+            if (size - (head - lane->cached_read_index) < needed) {
+                break;  /* Lane full */
+            }
+        }
+
+        /* A record never wraps: mark the tail of the lane as padding and start again at 0 */
+        if (needed > bytes) {
+            uint32_t skip = RECORD_PADDING | (uint32_t)(needed - bytes);
+
+            memcpy(&data[head & (size - 1)], &skip, sizeof(skip));
+            head += needed - bytes;
+        }
+
+        header.length = (uint32_t)(sizeof(header) + record->payload_length);
+        header.key = record->key;
+        header.timestamp_ns = record->timestamp_ns;
+        memcpy(&data[head & (size - 1)], &header, sizeof(header));
+        if (record->payload_length > 0) {
+            memcpy(&data[(head & (size - 1)) + sizeof(header)], record->payload, record->payload_length);
+        }
+        head += bytes;
+    }
+
+    if (head != start) {
+        atomic_store_explicit(&lane->write_index, head, memory_order_release);
+        notify_consumer(shm, lane, start, head);
+    }
+    return written;
+}
+
+/*
+ * Name    : write_records
+ * Purpose : Write a batch of records into a producer's lane, applying its overflow policy
+ *           (overwrite is treated as drop, see the file description) and updating its counters
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number, records, number of records
+ * Outputs : Updated lane and producer counters (in records); may block (OVERFLOW_BLOCK)
+ * Returns : Number of records written, or -1 if a payload is larger than RECORD_MAX_PAYLOAD or
+ *           than a record can be in this lane (half the lane)
+ */
+int write_records(shared_memory_t *shm, int semid, int lane, const record_t *records, int count) {
+    producer_slot_t *producer = &shm->producers[lane];
+    int written;
+
+    for (int i = 0; i < count; i++) {
+        if (records[i].payload_length > RECORD_MAX_PAYLOAD ||
+            record_size(records[i].payload_length) > lane_capacity(shm) / 2) {
+            return -1;
+        }
+    }
+
+    ring_lock(shm, semid);
+    written = record_write(shm, lane, records, count);
+    ring_unlock(shm, semid);
+
+    if (written < count && producer->policy == OVERFLOW_BLOCK) {
+        ring_lane_t *ring = &shm->lanes[lane];
+        uint64_t size = lane_capacity(shm);
+        struct timespec start;
+        struct timespec end;
+        struct timespec timeout = { 0, BLOCK_RECHECK_NS };
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (written < count) {
+            unsigned int seq = atomic_load_explicit(&ring->space_futex, memory_order_acquire);
+            uint64_t head = atomic_load_explicit(&ring->write_index, memory_order_relaxed);
+            uint64_t needed = record_space(size, head, record_size(records[written].payload_length));
+            int interrupted = 0;
+
+            /* Announce that we are going to sleep before the final check, so no wakeup is lost */
+            atomic_store_explicit(&ring->producer_waiting, 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (size - (head - atomic_load_explicit(&ring->read_index, memory_order_acquire)) < needed) {
+                interrupted = (futex_wait(&ring->space_futex, seq, &timeout) == -1 && errno == EINTR);
+            }
+            atomic_store_explicit(&ring->producer_waiting, 0, memory_order_relaxed);
+
+            ring_lock(shm, semid);
+            written += record_write(shm, lane, records + written, count - written);
+            ring_unlock(shm, semid);
+
+            if (interrupted) {
+                break;  /* Let the caller see its stop flag; the rest is counted as dropped */
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        counter_add(&producer->blocked_ns, (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL +
+                                           (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec);
+    }
+
+    counter_add(&producer->written, (uint64_t)written);
+    counter_add(&producer->dropped, (uint64_t)(count - written));
+
+    return written;
+}
+
+/*
+ * Name    : write_letters_as_records
+ * Purpose : Record format producers: write one event record per letter, keyed by the letter and
+ *           sharing one timestamp; payload lengths cycle through 0..max_payload so the framing sees
+ *           every size
+ * Input   : Pointer to shared memory, semaphore ID, producer/lane number, letters, number of
+ *           letters, largest payload (checked with record_payload_from_env)
+ * Outputs : Records written to the lane; letters that could not be framed count as dropped
+ * Returns : Number of records written, or -1 on error
+ */
+int write_letters_as_records(shared_memory_t *shm, int semid, int lane, const symbol_t *letters, int count,
+                             int max_payload) {
+    static record_t *records = NULL;
+    static int capacity = 0;
+    static unsigned char payload[RECORD_MAX_PAYLOAD];
+    static uint64_t sequence = 0;
+    struct timespec now;
+    int written;
+
+    if (count > capacity) {
+        record_t *grown = realloc(records, (size_t)count * sizeof(record_t));
+
+        if (grown == NULL) {
+            perror("write_letters_as_records: realloc");
+            counter_add(&shm->producers[lane].dropped, (uint64_t)count);
+            return -1;
+        }
+        records = grown;
+        capacity = count;
+        memset(payload, lane, sizeof(payload));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    for (int i = 0; i < count; i++, sequence++) {
+        records[i].key = (uint32_t)(letters[i] - MIN_LETTER);
+        records[i].timestamp_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+        records[i].payload_length = (uint32_t)(sequence % (uint64_t)(max_payload + 1));
+        records[i].payload = payload;
+    }
+
+    written = write_records(shm, semid, lane, records, count);
+    if (written == -1) {
+        /* A payload too large for the lane: nothing was written or counted */
+        counter_add(&shm->producers[lane].dropped, (uint64_t)count);
+    }
+    return written;
+}
+
+/*
+ * Name    : record_payload_from_env
+ * Purpose : Read the largest record payload from $HISTO_RECORD_PAYLOAD (default 0) and check that
+ *           a record with it fits this ring's lanes (write_records takes at most half a lane)
+ * Input   : Pointer to shared memory
+ * Outputs : Error message on stderr if the value is not usable
+ * Returns : Largest payload in bytes, or -1 if it is out of range or does not fit
+ */
+int record_payload_from_env(const shared_memory_t *shm) {
+    const char *text = getenv("HISTO_RECORD_PAYLOAD");
+    uint64_t half_lane = lane_capacity(shm) / 2;
+    int payload = (text != NULL) ? atoi(text) : 0;
+
+    if (payload < 0 || payload > RECORD_MAX_PAYLOAD) {
+        fprintf(stderr, "HISTO_RECORD_PAYLOAD must be 0 to %d bytes\n", RECORD_MAX_PAYLOAD);
+        return -1;
+    }
+    if (shm->ring_format == RING_FORMAT_RECORDS && record_size((uint32_t)payload) > half_lane) {
+        fprintf(stderr, "HISTO_RECORD_PAYLOAD of %d bytes does not fit lanes of %llu bytes (at most %llu)\n",
+                payload, (unsigned long long)lane_capacity(shm),
+                (unsigned long long)((half_lane & ~(uint64_t)(RECORD_ALIGN - 1)) - sizeof(record_header_t)));
+        return -1;
+    }
+    return payload;
+}
+
+/*
+ * Name    : read_records
+ * Purpose : Dequeue complete records from a lane into a batch, releasing them with a single store
+ * Input   : Pointer to shared memory, lane number, batch to append to, most records to take
+ * Outputs : Records and their payloads appended to the batch
+ * Returns : Number of records read
+ */
+int read_records(shared_memory_t *shm, int lane_no, record_batch_t *batch, int max_records) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    const unsigned char *data = (const unsigned char *)lane_data(shm, lane_no);
+    uint64_t size = lane_capacity(shm);
+    uint64_t start = atomic_load_explicit(&lane->read_index, memory_order_relaxed);
+    uint64_t tail = start;
+    uint64_t write_idx = atomic_load_explicit(&lane->write_index, memory_order_acquire);
+    int read_count = 0;
+
+    lane->cached_write_index = write_idx;
+    while (tail < write_idx && read_count < max_records && batch->count < RECORD_BATCH_MAX) {
+        record_header_t header;
+        record_t *record = &batch->records[batch->count];
+        uint32_t payload_length;
+
+        memcpy(&header.length, &data[tail & (size - 1)], sizeof(header.length));
+        if (header.length & RECORD_PADDING) {
+            if ((header.length & ~RECORD_PADDING) == 0) {
+                break;  /* Not a valid marker (should not happen), leave the lane as it is */
+            }
+            tail += header.length & ~RECORD_PADDING;  /* Rest of the lane is padding */
+            continue;
+        }
+        memcpy(&header, &data[tail & (size - 1)], sizeof(header));
+        if (header.length < sizeof(header) || record_size(header.length - sizeof(header)) > write_idx - tail) {
+            break;  /* Not a valid record (should not happen), leave the lane as it is */
+        }
+
+        payload_length = header.length - (uint32_t)sizeof(header);
+        if (batch->used + payload_length > sizeof(batch->data)) {
+            break;  /* Batch full, the record is read next time */
+        }
+        memcpy(&batch->data[batch->used], &data[(tail & (size - 1)) + sizeof(header)], payload_length);
+        record->key = header.key;
+        record->payload_length = payload_length;
+        record->timestamp_ns = header.timestamp_ns;
+        record->payload = &batch->data[batch->used];
+        batch->used += payload_length;
+        batch->count++;
+        read_count++;
+        tail += record_size(payload_length);
+    }
+
+    if (tail != start) {
+        atomic_store_explicit(&lane->read_index, tail, memory_order_release);
+        notify_producer(lane);
+    }
+    return read_count;
+}
+
+/*
+ * Name    : read_records_from_lanes
+ * Purpose : Batched dequeue across every lane, with the same fairness as bulk_read_from_lanes
+ * Input   : Pointer to shared memory, rotating start lane (updated), batch (emptied first),
+ *           most records to take (at most RECORD_BATCH_MAX)
+ * Outputs : Batch filled
+ * Returns : Number of records read
+ */
+int read_records_from_lanes(shared_memory_t *shm, int *next_lane, record_batch_t *batch, int max_records) {
+    int lane_count = (int)shm->header.lane_count;
+    int quota;
+
+    if (max_records > RECORD_BATCH_MAX) {
+        max_records = RECORD_BATCH_MAX;
+    }
+    quota = (max_records / lane_count > 0) ? max_records / lane_count : 1;
+    batch->count = 0;
+    batch->used = 0;
+
+    for (int pass = 0; pass < 2 && batch->count < max_records; pass++) {
+        for (int i = 0; i < lane_count && batch->count < max_records; i++) {
+            int lane = (*next_lane + i) % lane_count;
+            int wanted = max_records - batch->count;
+
+            if (pass == 0 && wanted > quota) {
+                wanted = quota;
+            }
+            read_records(shm, lane, batch, wanted);
+        }
+    }
+    *next_lane = (*next_lane + 1) % lane_count;
+
+    return batch->count;
+}
+
+/*
+ * Name    : ring_peek
+ * Purpose : Zero-copy read, step 1: expose unread letters of a lane where they lie in the ring
+ * Input   : Pointer to shared memory, lane number, most letters wanted, span
+ * Outputs : span points at the unread letters inside the ring (two pieces across the wrap point)
+ * Returns : Number of letters available in the span
+ */
+int ring_peek(shared_memory_t *shm, int lane_no, int count, ring_span_t *span) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    uint64_t tail = atomic_load_explicit(&lane->read_index, memory_order_acquire);
+    int available = clamp_count(lane->cached_write_index - tail);
+
+    if (available < count) {
+        /* Cached copy looks too empty, refresh it from the producer's cache line */
+        lane->cached_write_index = atomic_load_explicit(&lane->write_index, memory_order_acquire);
+        available = clamp_count(lane->cached_write_index - tail);
+    }
+    if (available > count) {
+        available = count;
+    }
+    lane_span(shm, lane_no, tail, (available > 0) ? available : 0, span);
+    return (available > 0) ? available : 0;
+}
+
+/*
+ * Name    : ring_release
+ * Purpose : Zero-copy read, step 2: hand peeked slots back to the producer
+ * Input   : Pointer to shared memory, lane number, number of letters consumed (at most the number peeked)
+ * Outputs : read_index advanced, a producer blocked on a full lane woken
+ * Returns : 1 on success, 0 if an overwriting producer reclaimed the slots while they were peeked
+ *           (the letters seen may then be a mix of old and new ones)
+ */
+int ring_release(shared_memory_t *shm, int lane_no, int count) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    uint64_t tail = atomic_load_explicit(&lane->read_index, memory_order_relaxed);
+
+    if (count <= 0) {
+        return 1;
+    }
+    if (!atomic_compare_exchange_strong_explicit(&lane->read_index, &tail, tail + (uint64_t)count,
+                                                 memory_order_acq_rel, memory_order_relaxed)) {
+        return 0;
+    }
+    notify_producer(lane);
+    return 1;
+}
+
+/*
+ * Name    : consume_lane
+ * Purpose : Pass up to count letters of one lane to a consumer function, in place when possible
+ * Input   : Pointer to shared memory, lane number, most letters to consume, consumer function
+ * Outputs : Letters consumed and released
+ * Returns : Number of letters consumed
+ */
+static int consume_lane(shared_memory_t *shm, int lane, int count, ring_consume_t consume) {
+    ring_span_t span;
+    int peeked;
+
+    /* An overwriting producer may reclaim slots while they are being read; copy those lanes out first */
+    if (shm->producers[lane].policy == OVERFLOW_OVERWRITE) {
+        symbol_t copy[CONSUME_COPY_BATCH];
+        int total = 0;
+        int got;
+
+        do {
+            got = bulk_read_from_buffer(shm, lane, copy, (count - total < CONSUME_COPY_BATCH) ? count - total
+                                                                                            : CONSUME_COPY_BATCH);
+            consume(copy, got);
+            total += got;
+        } while (got == CONSUME_COPY_BATCH && total < count);
+        return total;
+    }
+
+    peeked = ring_peek(shm, lane, count, &span);
+    if (peeked > 0) {
+        consume(span.first, span.first_count);
+        if (span.second_count > 0) {
+            consume(span.second, span.second_count);
+        }
+        ring_release(shm, lane, peeked);
+    }
+    return peeked;
+}
+
+/*
+ * Name    : consume_from_lanes
+ * Purpose : Zero-copy counterpart of bulk_read_from_lanes: hand letters from every lane, with the
+ *           same fairness, straight from shared memory to a consumer function
+ * Input   : Pointer to shared memory, rotating start lane (updated), most letters to consume,
+ *           consumer function (called once or twice per lane visited)
+ * Outputs : Letters consumed and released
+ * Returns : Number of letters consumed
+ */
+int consume_from_lanes(shared_memory_t *shm, int *next_lane, int count, ring_consume_t consume) {
+    return consume_from_lane_set(shm, 0, 1, next_lane, count, consume);
+}
+
+/*
+ * Name    : lane_set_size
+ * Purpose : Count the lanes first, first + stride, first + 2 * stride, ... that exist
+ * Input   : Pointer to shared memory, first lane, stride
+ * Outputs : None
+ * Returns : Number of lanes in the set
+ */
+static int lane_set_size(const shared_memory_t *shm, int first, int stride) {
+    int lane_count = (int)shm->header.lane_count;
+
+    return (first < lane_count) ? (lane_count - first + stride - 1) / stride : 0;
+}
+
+/*
+ * Name    : consume_from_lane_set
+ * Purpose : consume_from_lanes over the lanes first, first + stride, ... only, so several consumer
+ *           threads can each own a disjoint set of lanes
+ * Input   : Pointer to shared memory, first lane, stride, rotating start position within the set
+ *           (updated), most letters to consume, consumer function
+ * Outputs : Letters consumed and released
+ * Returns : Number of letters consumed
+ */
+int consume_from_lane_set(shared_memory_t *shm, int first, int stride, int *next_lane, int count,
+                          ring_consume_t consume) {
+    int set_size = lane_set_size(shm, first, stride);
+    int quota;
+    int total = 0;
+
+    if (set_size == 0) {
+        return 0;
+    }
+    quota = (count / set_size > 0) ? count / set_size : 1;
+    for (int pass = 0; pass < 2 && total < count; pass++) {
+        for (int i = 0; i < set_size && total < count; i++) {
+            int lane = first + ((*next_lane + i) % set_size) * stride;
+            int wanted = count - total;
+
+            if (pass == 0 && wanted > quota) {
+                wanted = quota;
+            }
+            total += consume_lane(shm, lane, wanted, consume);
+        }
+    }
+    *next_lane = (*next_lane + 1) % set_size;
+
+    return total;
+}
+
+/*
+ * Name    : consume_packed_lane
+ * Purpose : Pass up to count packed words of one lane to a consumer function where they lie
+ * Input   : Pointer to shared memory, lane number, most words to consume, consumer function
+ * Outputs : Words consumed and released
+ * Returns : Number of words consumed
+ */
+static int consume_packed_lane(shared_memory_t *shm, int lane_no, int count, ring_consume_packed_t consume) {
+    ring_lane_t *lane = &shm->lanes[lane_no];
+    const uint64_t *data = (const uint64_t *)lane_data(shm, lane_no);
+    uint64_t size = lane_capacity(shm);
+    uint64_t tail = atomic_load_explicit(&lane->read_index, memory_order_relaxed);
+    uint64_t pos = tail & (size - 1);
+    int available = clamp_count(lane->cached_write_index - tail);
+    int first;
+
+    if (available < count) {
+        /* Cached copy looks too empty, refresh it from the producer's cache line */
+        lane->cached_write_index = atomic_load_explicit(&lane->write_index, memory_order_acquire);
+        available = clamp_count(lane->cached_write_index - tail);
+    }
+    if (available > count) {
+        available = count;
+    }
+    if (available <= 0) {
+        return 0;
+    }
+
+    first = (size - pos < (uint64_t)available) ? (int)(size - pos) : available;
+    consume(&data[pos], first);
+    if (available > first) {
+        consume(data, available - first);
+    }
+    atomic_store_explicit(&lane->read_index, tail + (uint64_t)available, memory_order_release);
+    notify_producer(lane);
+    return available;
+}
+
+/*
+ * Name    : consume_packed_from_lanes
+ * Purpose : consume_from_lanes for RING_FORMAT_PACKED: hand packed words from every lane, with the
+ *           same fairness, straight from shared memory to a consumer function
+ * Input   : Pointer to shared memory, rotating start lane (updated), most words to consume,
+ *           consumer function (called once or twice per lane visited)
+ * Outputs : Words consumed and released
+ * Returns : Number of words consumed
+ */
+int consume_packed_from_lanes(shared_memory_t *shm, int *next_lane, int count, ring_consume_packed_t consume) {
+    return consume_packed_from_lane_set(shm, 0, 1, next_lane, count, consume);
+}
+
+/*
+ * Name    : consume_packed_from_lane_set
+ * Purpose : consume_from_lane_set for RING_FORMAT_PACKED
+ * Input   : Pointer to shared memory, first lane, stride, rotating start position within the set
+ *           (updated), most words to consume, consumer function
+ * Outputs : Words consumed and released
+ * Returns : Number of words consumed
+ */
+int consume_packed_from_lane_set(shared_memory_t *shm, int first, int stride, int *next_lane, int count,
+                                 ring_consume_packed_t consume) {
+    int set_size = lane_set_size(shm, first, stride);
+    int quota;
+    int total = 0;
+
+    if (set_size == 0) {
+        return 0;
+    }
+    quota = (count / set_size > 0) ? count / set_size : 1;
+    for (int pass = 0; pass < 2 && total < count; pass++) {
+        for (int i = 0; i < set_size && total < count; i++) {
+            int lane = first + ((*next_lane + i) % set_size) * stride;
+            int wanted = count - total;
+
+            if (pass == 0 && wanted > quota) {
+                wanted = quota;
+            }
+            total += consume_packed_lane(shm, lane, wanted, consume);
+        }
+    }
+    *next_lane = (*next_lane + 1) % set_size;
+
+    return total;
+}
+
+/*
+ * Name    : get_used_space
+ * Purpose : Calculate how many published letters are waiting to be read in a lane
+ * Input   : Pointer to shared memory buffer, lane number
+ * Outputs : None
+ * Returns : Number of letters in the lane
+ */
+int get_used_space(shared_memory_t *shm, int lane) {
+    uint64_t write_idx = atomic_load_explicit(&shm->lanes[lane].write_index, memory_order_acquire);
+    uint64_t read_idx = atomic_load_explicit(&shm->lanes[lane].read_index, memory_order_relaxed);
+
+    return clamp_count(write_idx - read_idx);
+}
+
+/*
+ * Name    : get_total_used_space
+ * Purpose : Calculate how many published letters are waiting to be read across all lanes
+ * Input   : Pointer to shared memory buffer
+ * Outputs : None
+ * Returns : Number of letters in the buffer
+ */
+long get_total_used_space(shared_memory_t *shm) {
+    long total = 0;
+
+    for (int lane = 0; lane < (int)shm->header.lane_count; lane++) {
+        total += get_used_space(shm, lane);
+    }
+    return total;
+}
+
+/*
+ * Name    : lanes_ready
+ * Purpose : Check whether any lane has reached the wake threshold
+ * Input   : Pointer to shared memory buffer
+ * Outputs : None
+ * Returns : 1 if a lane holds at least wake_threshold letters, 0 otherwise
+ */
+static int lanes_ready(shared_memory_t *shm) {
+    for (int lane = 0; lane < (int)shm->header.lane_count; lane++) {
+        if ((uint64_t)get_used_space(shm, lane) >= shm->wake_threshold) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Name    : wait_for_data
+ * Purpose : Block DC until some lane holds at least wake_threshold letters
+ * Input   : Pointer to shared memory, relative timeout (NULL waits forever)
+ * Outputs : Sleeps on the data futex when there is not enough data
+ * Returns : 1 if the threshold is reached, 0 on timeout or signal
+ */
+int wait_for_data(shared_memory_t *shm, const struct timespec *timeout) {
+    unsigned int seq = atomic_load_explicit(&shm->data_futex, memory_order_acquire);
+    int ready;
+
+    /* Announce that we are going to sleep before the final check, so no wakeup is lost */
+    atomic_store_explicit(&shm->consumer_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    ready = lanes_ready(shm);
+    if (!ready) {
+        futex_wait(&shm->data_futex, seq, timeout);
+        ready = lanes_ready(shm);
+    }
+
+    atomic_store_explicit(&shm->consumer_waiting, 0, memory_order_relaxed);
+    return ready;
+}
+
+/*
+ * Name    : ring_lock
+ * Purpose : Acquire the semaphore around a buffer access when running in semaphore mode
+ * Input   : Pointer to shared memory, semaphore ID
+ * Outputs : Blocks until the semaphore is available (semaphore mode only)
+ * Returns : None
+ */
+void ring_lock(shared_memory_t *shm, int semid) {
+    struct timespec start, end;
+
+    if (shm->ring_mode != RING_MODE_SEMAPHORE) {
+        return;
+    }
+    if (lock_wait_counter == NULL) {
+        semaphore_wait(semid);
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    semaphore_wait(semid);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    /* A real read-modify-write: DC's consumer threads all add to the same counter */
+    atomic_fetch_add_explicit(lock_wait_counter, (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL +
+                                                 (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec,
+                              memory_order_relaxed);
+}
+
+/*
+ * Name    : ring_track_lock_wait
+ * Purpose : Choose where ring_lock adds this process's semaphore wait time
+ * Input   : Counter owned by the calling process (its producer slot or DC's block), or NULL to stop
+ * Outputs : Later ring_lock calls update the counter
+ * Returns : None
+ */
+void ring_track_lock_wait(_Atomic uint64_t *counter) {
+    lock_wait_counter = counter;
+}
+
+/*
+ * Name    : ring_unlock
+ * Purpose : Release the semaphore taken by ring_lock
+ * Input   : Pointer to shared memory, semaphore ID
+ * Outputs : Releases the semaphore (semaphore mode only)
+ * Returns : None
+ */
+void ring_unlock(shared_memory_t *shm, int semid) {
+    if (shm->ring_mode == RING_MODE_SEMAPHORE) {
+        semaphore_signal(semid);
+    }
+}
+
+/*
+ * Name    : parse_ring_mode
+ * Purpose : Convert a ring mode name ("lockfree" or "semaphore") to its constant
+ * Input   : Mode name
+ * Outputs : None
+ * Returns : RING_MODE_LOCKFREE, RING_MODE_SEMAPHORE, or -1 if the name is unknown
+ */
+int parse_ring_mode(const char *name) {
+    if (strcmp(name, "lockfree") == 0) {
+        return RING_MODE_LOCKFREE;
+    }
+    if (strcmp(name, "semaphore") == 0) {
+        return RING_MODE_SEMAPHORE;
+    }
+    return -1;
+}
+
+/*
+ * Name    : parse_overflow_policy
+ * Purpose : Convert an overflow policy name ("drop", "block" or "overwrite") to its constant
+ * Input   : Policy name
+ * Outputs : None
+ * Returns : OVERFLOW_DROP_NEWEST, OVERFLOW_BLOCK, OVERFLOW_OVERWRITE, or -1 if the name is unknown
+ */
+int parse_overflow_policy(const char *name) {
+    if (strcmp(name, "drop") == 0) {
+        return OVERFLOW_DROP_NEWEST;
+    }
+    if (strcmp(name, "block") == 0) {
+        return OVERFLOW_BLOCK;
+    }
+    if (strcmp(name, "overwrite") == 0) {
+        return OVERFLOW_OVERWRITE;
+    }
+    return -1;
+}
+
+/*
+ * Name    : overflow_policy_name
+ * Purpose : Get a printable name for an overflow policy
+ * Input   : Policy constant
+ * Outputs : None
+ * Returns : Policy name
+ */
+const char *overflow_policy_name(int policy) {
+    switch (policy) {
+    case OVERFLOW_BLOCK:
+        return "block";
+    case OVERFLOW_OVERWRITE:
+        return "overwrite";
+    default:
+        return "drop";
+    }
+}
+
+/*
+ * Name    : ring_mode_name
+ * Purpose : Get a printable name for a ring mode
+ * Input   : Ring mode constant
+ * Outputs : None
+ * Returns : Mode name
+ */
+const char *ring_mode_name(int ring_mode) {
+    return (ring_mode == RING_MODE_SEMAPHORE) ? "semaphore" : "lockfree";
+}
+
+/*
+ * Name    : parse_ring_format
+ * Purpose : Convert a ring format name ("symbols", "records" or "packed") to its constant
+ * Input   : Format name
+ * Outputs : None
+ * Returns : RING_FORMAT_SYMBOLS, RING_FORMAT_RECORDS, RING_FORMAT_PACKED, or -1 if the name is
+ *           unknown (or "packed" in a domain too wide for it, see PACKED_RING_SUPPORTED)
+ */
+int parse_ring_format(const char *name) {
+    if (strcmp(name, "symbols") == 0) {
+        return RING_FORMAT_SYMBOLS;
+    }
+    if (strcmp(name, "records") == 0) {
+        return RING_FORMAT_RECORDS;
+    }
+    if (strcmp(name, "packed") == 0 && PACKED_RING_SUPPORTED) {
+        return RING_FORMAT_PACKED;
+    }
+    return -1;
+}
+
+/*
+ * Name    : ring_format_name
+ * Purpose : Get a printable name for a ring format
+ * Input   : Ring format constant
+ * Outputs : None
+ * Returns : Format name
+ */
+const char *ring_format_name(int ring_format) {
+    if (ring_format == RING_FORMAT_RECORDS) {
+        return "records";
+    }
+    return (ring_format == RING_FORMAT_PACKED) ? "packed" : "symbols";
+}
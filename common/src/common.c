@@ -5,30 +5,255 @@
  * FIRST VERSION: 08-04-2025
  * DESCRIPTION:
  * Contains utility functions used across the system.
- * Currently includes random letter generation between 'A' and 'T'.
+ * Currently includes random letter generation over the symbol domain (A-T unless built otherwise).
+ * The generator is xoshiro256** (Blackman and Vigna) with its state private to the process, seeded
+ * through splitmix64. A 64-bit draw below the largest multiple of LETTER_RANGE^k is exactly uniform
+ * over k base-LETTER_RANGE digits, so the batch generator takes k letters (13 for A-T) from each
+ * accepted draw and rejects the rest (under 0.1% of draws for A-T), which keeps it free of bias.
+ * REFERENCES:
+ * https://prng.di.unimi.it/
  */
+#define _POSIX_C_SOURCE 200809L  // Enables clock_gettime
+
 #include "../inc/common.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+static uint64_t rng_state[4];
+static int letters_per_draw;   // k: letters taken from one accepted draw
+static uint64_t draw_limit;    // LETTER_RANGE^k * floor(2^64 / LETTER_RANGE^k), draws at or above are rejected
+static uint64_t letter_limit;  // Same for a single letter (generate_random_letter)
 
 /*
- * Name    : init_random
- * Purpose : Seed the random number generator using current time
+ * Name    : splitmix64
+ * Purpose : Expand a seed into well-mixed 64-bit values for the generator state
+ * Input   : Pointer to the splitmix64 state
+ * Outputs : State advanced
+ * Returns : Next 64-bit value
+ */
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Name    : rotl
+ * Purpose : Rotate a 64-bit value left
+ * Input   : Value, rotation count (1..63)
+ * Outputs : None
+ * Returns : Rotated value
+ */
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/*
+ * Name    : next_random
+ * Purpose : Draw the next 64-bit value from xoshiro256**
  * Input   : None
- * Outputs : Seeds rand()
+ * Outputs : Generator state advanced
+ * Returns : Random 64-bit value
+ */
+static inline uint64_t next_random(void) {
+    uint64_t result = rotl(rng_state[1] * 5, 7) * 9;
+    uint64_t t = rng_state[1] << 17;
+
+    rng_state[2] ^= rng_state[0];
+    rng_state[3] ^= rng_state[1];
+    rng_state[1] ^= rng_state[2];
+    rng_state[0] ^= rng_state[3];
+    rng_state[2] ^= t;
+    rng_state[3] = rotl(rng_state[3], 45);
+    return result;
+}
+
+/*
+ * Name    : init_random
+ * Purpose : Seed this process's generator
+ * Input   : Seed, or 0 to seed from the clock and process ID
+ * Outputs : Generator state and range reduction limits set
  * Returns : None
  */
-void init_random(void) {
-    srand(time(NULL));
+void init_random(uint64_t seed) {
+    uint64_t power = 1;
+
+    if (seed == 0) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        seed = ((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec) ^ ((uint64_t)getpid() << 32);
+    }
+    for (int i = 0; i < 4; i++) {
+        rng_state[i] = splitmix64(&seed);
+    }
+
+    // Largest k with LETTER_RANGE^k <= 2^64 - 1, and the rejection limits for k letters and for one
+    letters_per_draw = 0;
+    while (power <= UINT64_MAX / LETTER_RANGE) {
+        power *= LETTER_RANGE;
+        letters_per_draw++;
+    }
+    draw_limit = (UINT64_MAX / power) * power;
+    letter_limit = (UINT64_MAX / LETTER_RANGE) * LETTER_RANGE;
+}
+
+/*
+ * Name    : seed_from_env
+ * Purpose : Pick a repeatable seed when the named environment variable is set
+ * Input   : Environment variable name, stream number (e.g. the producer's lane) so that
+ *           producers sharing one seed still draw different sequences
+ * Outputs : None
+ * Returns : Seed for init_random (0, meaning clock and PID, if the variable is not set)
+ */
+uint64_t seed_from_env(const char *name, int stream) {
+    const char *text = getenv(name);
+
+    if (text == NULL || *text == '\0') {
+        return 0;
+    }
+    return strtoull(text, NULL, 0) * 0x9e3779b97f4a7c15ULL + (uint64_t)stream + 1;
 }
 
 /*
  * Name    : generate_random_letter
- * Purpose : Generate a random uppercase letter from A to T
+ * Purpose : Generate a random uppercase letter from A to T (or symbol of the configured domain)
  * Input   : None
- * Outputs : None
- * Returns : Random character between 'A' and 'T'
+ * Outputs : Generator state advanced
+ * Returns : Random symbol between MIN_LETTER and MAX_LETTER
  */
-char generate_random_letter(void) {
-    return 'A' + (rand() % ('T' - 'A' + 1));
-}
\ No newline at end of file
+symbol_t generate_random_letter(void) {
+    uint64_t x;
+
+    if (letters_per_draw == 0) {
+        init_random(0);  // Never seeded explicitly
+    }
+    do {
+        x = next_random();
+    } while (x >= letter_limit);
+    return (symbol_t)(MIN_LETTER + x % LETTER_RANGE);
+}
+
+/*
+ * Name    : generate_random_letters
+ * Purpose : Fill an array with random letters from A to T (or symbols), several per 64-bit draw
+ * Input   : Destination array, number of letters
+ * Outputs : letters[0..count-1] filled
+ * Returns : None
+ */
+void generate_random_letters(symbol_t *letters, int count) {
+    int i = 0;
+
+    if (letters_per_draw == 0) {
+        init_random(0);  // Never seeded explicitly
+    }
+    while (i < count) {
+        uint64_t x = next_random();
+        int n = (count - i < letters_per_draw) ? count - i : letters_per_draw;
+
+        if (x >= draw_limit) {
+            continue;  // Would favour the low digits, draw again
+        }
+        // Division by a constant compiles to a multiply, and the digits do not depend on each other's letters
+        for (int j = 0; j < n; j++) {
+            letters[i + j] = (symbol_t)(MIN_LETTER + x % LETTER_RANGE);
+            x /= LETTER_RANGE;
+        }
+        i += n;
+    }
+}
+
+/*
+ * Name    : format_symbol
+ * Purpose : Text label of a histogram bin ("A" for letters, hex for the byte and 16-bit domains)
+ * Input   : Destination, its size, bin number (0..LETTER_RANGE-1)
+ * Outputs : Label written
+ * Returns : Label length
+ */
+int format_symbol(char *text, int size, int bin) {
+    return snprintf(text, (size_t)size, SYMBOL_FORMAT, MIN_LETTER + bin);
+}
+
+/*
+ * Name    : pack_letters
+ * Purpose : Encode letters in the packed form, filling the last word up with PACKED_PAD
+ * Input   : Letters, number of letters, destination (PACKED_WORDS(count) words)
+ * Outputs : Words written
+ * Returns : Number of words written
+ */
+int pack_letters(const symbol_t *letters, int count, uint64_t *words) {
+    int full = count / PACKED_PER_WORD;
+    int rest = count % PACKED_PER_WORD;
+
+#if SYMBOL_DOMAIN == 20 && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // A-T: squeeze 8 and then 4 letter bytes into 5-bit fields inside a register (SWAR). Setting
+    // each byte's top bit first keeps the subtraction of 'A' from borrowing across bytes.
+    for (int w = 0; w < full; w++) {
+        const unsigned char *field = (const unsigned char *)letters + (size_t)w * PACKED_PER_WORD;
+        uint64_t low;
+        uint32_t high;
+
+        memcpy(&low, field, sizeof(low));
+        memcpy(&high, field + sizeof(low), sizeof(high));
+        low = ((low | 0x8080808080808080ULL) - 0x4141414141414141ULL) & 0x1f1f1f1f1f1f1f1fULL;
+        high = ((high | 0x80808080u) - 0x41414141u) & 0x1f1f1f1fu;
+        low = (low & 0x00ff00ff00ff00ffULL) | ((low & 0xff00ff00ff00ff00ULL) >> 3);   // Pairs, 10 bits per 16
+        low = (low & 0x0000ffff0000ffffULL) | ((low & 0xffff0000ffff0000ULL) >> 6);   // Quads, 20 bits per 32
+        low = (low & 0xfffffULL) | ((low >> 32) << 20);                               // 8 letters, 40 bits
+        high = (high & 0x00ff00ffu) | ((high & 0xff00ff00u) >> 3);
+        high = (high & 0xffffu) | ((high >> 16) << 10);                               // 4 letters, 20 bits
+        words[w] = low | ((uint64_t)high << 40);
+    }
+#else
+    // Whole words: a fixed number of fields, so the loop unrolls into shifts and ors
+    for (int w = 0; w < full; w++) {
+        const symbol_t *field = letters + (size_t)w * PACKED_PER_WORD;
+        uint64_t word = 0;
+
+        for (int i = 0; i < PACKED_PER_WORD; i++) {
+            word |= ((uint64_t)(field[i] - MIN_LETTER) & PACKED_MASK) << (i * PACKED_SYMBOL_BITS);
+        }
+        words[w] = word;
+    }
+#endif
+
+    // Last word: the letters left over, then padding
+    if (rest > 0) {
+        const symbol_t *field = letters + (size_t)full * PACKED_PER_WORD;
+        uint64_t word = 0;
+
+        for (int i = 0; i < PACKED_PER_WORD; i++) {
+            word |= ((i < rest) ? ((uint64_t)(field[i] - MIN_LETTER) & PACKED_MASK) : PACKED_PAD)
+                    << (i * PACKED_SYMBOL_BITS);
+        }
+        words[full++] = word;
+    }
+    return full;
+}
+
+/*
+ * Name    : unpack_letters
+ * Purpose : Decode packed words back into letters, skipping PACKED_PAD fields
+ * Input   : Words, number of words, destination (word_count * PACKED_PER_WORD letters)
+ * Outputs : Letters written
+ * Returns : Number of letters written
+ */
+int unpack_letters(const uint64_t *words, int word_count, symbol_t *letters) {
+    int count = 0;
+
+    for (int w = 0; w < word_count; w++) {
+        uint64_t word = words[w];
+
+        for (int i = 0; i < PACKED_PER_WORD; i++, word >>= PACKED_SYMBOL_BITS) {
+            if (!PACKED_RING_SUPPORTED || (word & PACKED_MASK) != PACKED_PAD) {
+                letters[count++] = (symbol_t)(MIN_LETTER + (word & PACKED_MASK));
+            }
+        }
+    }
+    return count;
+}
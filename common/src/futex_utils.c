@@ -0,0 +1,53 @@
+/*
+ * FILE: futex_utils.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * This file contains futex utility functions used to block and wake processes
+ * sharing a futex word in shared memory. The non-private futex operations are used
+ * because the word is shared between processes.
+ */
+#define _DEFAULT_SOURCE  // Enables syscall()
+
+#include "../inc/futex_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/*
+ * Name    : futex_wait
+ * Purpose : Sleep while the futex word still holds the expected value
+ * Input   : Futex word, expected value, relative timeout (NULL waits forever)
+ * Outputs : Blocks until woken, timed out or interrupted by a signal
+ * Returns : 0 if woken (or the word had already changed), -1 on timeout or signal
+ */
+int futex_wait(atomic_uint *word, unsigned int expected, const struct timespec *timeout) {
+    if (syscall(SYS_futex, (unsigned int *)word, FUTEX_WAIT, expected, timeout, NULL, 0) == -1) {
+        if (errno == EAGAIN) {
+            return 0;  /* Word changed before we slept */
+        }
+        if (errno != ETIMEDOUT && errno != EINTR) {
+            perror("futex wait");
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Name    : futex_wake
+ * Purpose : Wake every process sleeping on the futex word
+ * Input   : Futex word
+ * Outputs : Releases blocked processes, if any
+ * Returns : None
+ */
+void futex_wake(atomic_uint *word) {
+    if (syscall(SYS_futex, (unsigned int *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0) == -1) {
+        perror("futex wake");
+    }
+}
@@ -0,0 +1,474 @@
+/*
+ * FILE: histogram_kernel.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the letter counting kernels and their runtime dispatch.
+ * - scalar: a 256-entry table maps every byte to its bin (or to a reject bin), and four
+ *   sub-histograms of 32-bit counters take turns, merged into the caller's counts per chunk.
+ * - sse2/avx2: for a block of up to 255 vectors, each bin keeps a vector of byte counters that
+ *   is decremented by the compare-equal mask (-1 per match), then summed with psadbw. Bins are
+ *   handled SIMD_GROUP at a time so the counters stay in registers while the block stays in L1.
+ * Letters outside the symbol domain are never counted, only reported back through the return value.
+ * In the 16-bit domain every symbol is a bin, so the scalar kernel indexes the counts directly
+ * (a 65536-entry table and sub-histograms would not stay in cache) and nothing is ever rejected.
+ * The AVX2 kernel is compiled with a target attribute, so the file builds without -mavx2 and the
+ * kernel is only used when __builtin_cpu_supports says the CPU has it.
+ */
+#include "../inc/histogram_kernel.h"
+#include "../inc/common.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && SYMBOL_DOMAIN <= 64
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#define SUB_HISTOGRAMS 4            /* Scalar kernel: independent counters for neighbouring letters */
+#define SCALAR_CHUNK (1UL << 30)    /* Letters per merge, keeps the 32-bit sub-counters from overflowing */
+#define PACKED_CHUNK (SCALAR_CHUNK / PACKED_PER_WORD * PACKED_PER_WORD)  /* Same, in whole packed words */
+#define PACKED_FIELD_MASK ((1ULL << PACKED_FIELD_BITS) - 1)
+#define PACKED_FIELDS (PACKED_PER_WORD / PACKED_FIELD_SYMBOLS)
+#define SIMD_BLOCK_VECTORS 255      /* Byte counters hold at most 255 matches */
+#define SIMD_GROUP 10               /* Bins compared per pass over a block */
+#define SIMD_MIN_LETTERS 256        /* Smaller batches are not worth the SIMD setup */
+#define PACKED_MIN_LETTERS 4096     /* Smaller packed batches are not worth clearing and merging the sub-histograms */
+
+typedef size_t (*count_kernel_t)(const symbol_t *letters, size_t count, uint64_t *counts);
+
+#if SYMBOL_DOMAIN > 256
+/*
+ * Name    : count_scalar
+ * Purpose : Portable counting kernel for the 16-bit domain
+ * Input   : Symbols, number of symbols, counts to add to (LETTER_RANGE entries)
+ * Outputs : counts updated
+ * Returns : 0, every 16-bit value is a bin
+ */
+static size_t count_scalar(const symbol_t *letters, size_t count, uint64_t *counts) {
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        counts[letters[i]]++;
+        counts[letters[i + 1]]++;
+        counts[letters[i + 2]]++;
+        counts[letters[i + 3]]++;
+    }
+    for (; i < count; i++) {
+        counts[letters[i]]++;
+    }
+    return 0;
+}
+#else
+/*
+ * Name    : count_scalar
+ * Purpose : Portable counting kernel for one-byte domains
+ * Input   : Letters, number of letters, counts to add to (LETTER_RANGE entries)
+ * Outputs : counts updated
+ * Returns : Number of letters outside the domain
+ */
+static size_t count_scalar(const symbol_t *symbols, size_t count, uint64_t *counts) {
+    const unsigned char *letters = (const unsigned char *)symbols;
+    static uint16_t bin_of[256];
+    static int table_ready = 0;
+    uint32_t sub[SUB_HISTOGRAMS][LETTER_RANGE + 1];
+    size_t rejected = 0;
+
+    // Byte -> bin table, LETTER_RANGE is the reject bin (same contents every time, so rebuilding is harmless)
+    if (!table_ready) {
+        for (int byte = 0; byte < 256; byte++) {
+            bin_of[byte] = (byte >= MIN_LETTER && byte <= MAX_LETTER) ? (uint16_t)(byte - MIN_LETTER)
+                                                                      : (uint16_t)LETTER_RANGE;
+        }
+        table_ready = 1;
+    }
+
+    while (count > 0) {
+        size_t chunk = (count < SCALAR_CHUNK) ? count : SCALAR_CHUNK;
+        size_t i = 0;
+
+        memset(sub, 0, sizeof(sub));
+        for (; i + SUB_HISTOGRAMS <= chunk; i += SUB_HISTOGRAMS) {
+            sub[0][bin_of[letters[i]]]++;
+            sub[1][bin_of[letters[i + 1]]]++;
+            sub[2][bin_of[letters[i + 2]]]++;
+            sub[3][bin_of[letters[i + 3]]]++;
+        }
+        for (; i < chunk; i++) {
+            sub[0][bin_of[letters[i]]]++;
+        }
+
+        // Merge the sub-histograms
+        for (int bin = 0; bin < LETTER_RANGE; bin++) {
+            counts[bin] += (uint64_t)sub[0][bin] + sub[1][bin] + sub[2][bin] + sub[3][bin];
+        }
+        rejected += (size_t)sub[0][LETTER_RANGE] + sub[1][LETTER_RANGE] + sub[2][LETTER_RANGE] + sub[3][LETTER_RANGE];
+
+        letters += chunk;
+        count -= chunk;
+    }
+    return rejected;
+}
+#endif
+
+#ifdef HAVE_X86_KERNELS
+/*
+ * Name    : count_sse2
+ * Purpose : SSE2 counting kernel, 16 letters per compare
+ * Input   : Letters, number of letters, counts to add to
+ * Outputs : counts updated
+ * Returns : Number of letters outside the domain
+ */
+__attribute__((target("sse2")))
+static size_t count_sse2(const symbol_t *letters, size_t count, uint64_t *counts) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t counted = 0;  // Letters that landed in a bin
+    size_t vector_letters = count - count % 16;
+
+    for (size_t offset = 0; offset < vector_letters; offset += SIMD_BLOCK_VECTORS * 16) {
+        size_t vectors = (vector_letters - offset) / 16;
+
+        if (vectors > SIMD_BLOCK_VECTORS) {
+            vectors = SIMD_BLOCK_VECTORS;
+        }
+        for (int first = 0; first < LETTER_RANGE; first += SIMD_GROUP) {
+            __m128i acc[SIMD_GROUP];
+            uint64_t sums[2];
+
+            for (int j = 0; j < SIMD_GROUP; j++) {
+                acc[j] = zero;
+            }
+            for (size_t v = 0; v < vectors; v++) {
+                __m128i data = _mm_loadu_si128((const __m128i *)(letters + offset + v * 16));
+
+#pragma GCC unroll 16
+                for (int j = 0; j < SIMD_GROUP; j++) {
+                    // Bins past the last letter compare against NUL and are discarded below
+                    char target = (first + j < LETTER_RANGE) ? (char)(MIN_LETTER + first + j) : 0;
+
+                    acc[j] = _mm_sub_epi8(acc[j], _mm_cmpeq_epi8(data, _mm_set1_epi8(target)));
+                }
+            }
+            for (int j = 0; j < SIMD_GROUP && first + j < LETTER_RANGE; j++) {
+                _mm_storeu_si128((__m128i *)sums, _mm_sad_epu8(acc[j], zero));
+                counts[first + j] += sums[0] + sums[1];
+                counted += sums[0] + sums[1];
+            }
+        }
+    }
+
+    return (vector_letters - counted) + count_scalar(letters + vector_letters, count - vector_letters, counts);
+}
+
+/*
+ * Name    : count_avx2
+ * Purpose : AVX2 counting kernel, 32 letters per compare
+ * Input   : Letters, number of letters, counts to add to
+ * Outputs : counts updated
+ * Returns : Number of letters outside the domain
+ */
+__attribute__((target("avx2")))
+static size_t count_avx2(const symbol_t *letters, size_t count, uint64_t *counts) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t counted = 0;  // Letters that landed in a bin
+    size_t vector_letters = count - count % 32;
+
+    for (size_t offset = 0; offset < vector_letters; offset += SIMD_BLOCK_VECTORS * 32) {
+        size_t vectors = (vector_letters - offset) / 32;
+
+        if (vectors > SIMD_BLOCK_VECTORS) {
+            vectors = SIMD_BLOCK_VECTORS;
+        }
+        for (int first = 0; first < LETTER_RANGE; first += SIMD_GROUP) {
+            __m256i acc[SIMD_GROUP];
+            uint64_t sums[4];
+
+            for (int j = 0; j < SIMD_GROUP; j++) {
+                acc[j] = zero;
+            }
+            for (size_t v = 0; v < vectors; v++) {
+                __m256i data = _mm256_loadu_si256((const __m256i *)(letters + offset + v * 32));
+
+#pragma GCC unroll 16
+                for (int j = 0; j < SIMD_GROUP; j++) {
+                    // Bins past the last letter compare against NUL and are discarded below
+                    char target = (first + j < LETTER_RANGE) ? (char)(MIN_LETTER + first + j) : 0;
+
+                    acc[j] = _mm256_sub_epi8(acc[j], _mm256_cmpeq_epi8(data, _mm256_set1_epi8(target)));
+                }
+            }
+            for (int j = 0; j < SIMD_GROUP && first + j < LETTER_RANGE; j++) {
+                _mm256_storeu_si256((__m256i *)sums, _mm256_sad_epu8(acc[j], zero));
+                counts[first + j] += sums[0] + sums[1] + sums[2] + sums[3];
+                counted += sums[0] + sums[1] + sums[2] + sums[3];
+            }
+        }
+    }
+
+    return (vector_letters - counted) + count_scalar(letters + vector_letters, count - vector_letters, counts);
+}
+#endif
+
+/* Kernels from slowest to fastest; entries the CPU cannot run are skipped */
+static const struct {
+    const char *name;
+    count_kernel_t kernel;
+} kernels[] = {
+    { "scalar", count_scalar },
+#ifdef HAVE_X86_KERNELS
+    { "sse2", count_sse2 },
+    { "avx2", count_avx2 },
+#endif
+};
+
+#define KERNEL_COUNT ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+static int selected_kernel = -1;  // Index into kernels, -1 until the first call picks one
+
+/*
+ * Name    : kernel_supported
+ * Purpose : Check whether this CPU can run a kernel
+ * Input   : Index into kernels
+ * Outputs : None
+ * Returns : 1 if supported, 0 otherwise
+ */
+static int kernel_supported(int index) {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (kernels[index].kernel == count_sse2) {
+        return __builtin_cpu_supports("sse2");
+    }
+    if (kernels[index].kernel == count_avx2) {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    return index == 0;
+}
+
+/*
+ * Name    : select_count_kernel
+ * Purpose : Choose the counting kernel by name, or the fastest supported one
+ * Input   : "scalar", "sse2", "avx2", or NULL/"auto" for the fastest
+ * Outputs : Kernel used by count_letters updated
+ * Returns : 0 on success, -1 if the kernel is unknown or not supported by this CPU
+ */
+int select_count_kernel(const char *name) {
+    if (name == NULL || strcmp(name, "auto") == 0) {
+        for (int i = KERNEL_COUNT - 1; i >= 0; i--) {
+            if (kernel_supported(i)) {
+                selected_kernel = i;
+                return 0;
+            }
+        }
+    }
+    for (int i = 0; name != NULL && i < KERNEL_COUNT; i++) {
+        if (strcmp(name, kernels[i].name) == 0 && kernel_supported(i)) {
+            selected_kernel = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Name    : count_kernel_name
+ * Purpose : Name of the kernel count_letters uses
+ * Input   : None
+ * Outputs : Kernel picked if none was selected yet
+ * Returns : Kernel name
+ */
+const char *count_kernel_name(void) {
+    if (selected_kernel < 0) {
+        select_count_kernel(NULL);
+    }
+    return kernels[selected_kernel].name;
+}
+
+/*
+ * Name    : count_letters
+ * Purpose : Add a batch of letters to a histogram with the selected kernel
+ * Input   : Letters, number of letters, counts to add to (LETTER_RANGE entries)
+ * Outputs : counts updated
+ * Returns : Number of letters outside the domain (not counted)
+ */
+size_t count_letters(const symbol_t *letters, size_t count, uint64_t *counts) {
+    if (selected_kernel < 0) {
+        select_count_kernel(NULL);
+    }
+    if (count < SIMD_MIN_LETTERS) {
+        return count_scalar(letters, count, counts);
+    }
+    return kernels[selected_kernel].kernel(letters, count, counts);
+}
+
+/*
+ * Name    : count_packed_direct
+ * Purpose : Add packed symbols to a histogram one field at a time, shifting and masking each
+ *           symbol straight to its bin (no sub-histograms to clear and merge)
+ * Input   : Packed words, number of symbols in them, counts to add to (LETTER_RANGE entries)
+ * Outputs : counts updated
+ * Returns : Number of fields that are not a bin of the domain (not counted)
+ */
+static size_t count_packed_direct(const uint64_t *words, size_t count, uint64_t *counts) {
+    size_t full = count / PACKED_PER_WORD;
+    size_t rejected = 0;
+
+    for (size_t w = 0; w < full; w++) {
+        uint64_t word = words[w];
+
+        // Unrolled into constant shifts and masks, as in packed_counter_add
+#pragma GCC unroll 16
+        for (int symbol = 0; symbol < PACKED_PER_WORD; symbol++, word >>= PACKED_SYMBOL_BITS) {
+            uint64_t bin = word & PACKED_MASK;
+
+            if (bin < LETTER_RANGE) {
+                counts[bin]++;
+            } else {
+                rejected++;
+            }
+        }
+    }
+
+    // Symbols of a last, partly filled word
+    if (count % PACKED_PER_WORD != 0) {
+        uint64_t word = words[full];
+
+        for (size_t symbol = 0; symbol < count % PACKED_PER_WORD; symbol++, word >>= PACKED_SYMBOL_BITS) {
+            if ((word & PACKED_MASK) < LETTER_RANGE) {
+                counts[word & PACKED_MASK]++;
+            } else {
+                rejected++;
+            }
+        }
+    }
+    return rejected;
+}
+
+/*
+ * Name    : packed_counter_init
+ * Purpose : Start a packed counter with empty sub-histograms
+ * Input   : Counter
+ * Outputs : Counter cleared
+ * Returns : None
+ */
+void packed_counter_init(packed_counter_t *counter) {
+    memset(counter, 0, sizeof(*counter));
+}
+
+/*
+ * Name    : packed_counter_add
+ * Purpose : Collect a run of packed symbols: whole words go to the counter's sub-histograms, the
+ *           symbols of a partly filled last word straight to the histogram
+ * Input   : Counter, packed words, number of symbols in them, counts to add to (LETTER_RANGE entries)
+ * Outputs : Counter updated, counts updated by the partial word (and by a merge when the 32-bit
+ *           sub-counters are about to fill up)
+ * Returns : Number of fields added to counts that are not a bin of the domain (the rest are
+ *           reported by packed_counter_merge)
+ */
+size_t packed_counter_add(packed_counter_t *counter, const uint64_t *words, size_t count, uint64_t *counts) {
+#if PACKED_SYMBOL_BITS == 16
+    // Every 16-bit field is a bin, count straight into the histogram
+    (void)counter;
+    return count_packed_direct(words, count, counts);
+#else
+    size_t full = count / PACKED_PER_WORD;
+    size_t rejected = 0;
+
+    while (full > 0) {
+        size_t room = (PACKED_CHUNK - counter->pending) / PACKED_PER_WORD;
+        size_t run = (full < room) ? full : room;
+
+        if (run == 0) {
+            rejected += packed_counter_merge(counter, counts);
+            continue;
+        }
+        for (size_t w = 0; w < run; w++) {
+            uint64_t word = words[w];
+
+            // Unrolled into constant shifts and masks (-O2 does not unroll it by itself)
+#pragma GCC unroll 16
+            for (int field = 0; field < PACKED_FIELDS; field++) {
+                counter->sub[field % PACKED_SUB_HISTOGRAMS][(word >> (field * PACKED_FIELD_BITS)) & PACKED_FIELD_MASK]++;
+            }
+        }
+        counter->pending += run * PACKED_PER_WORD;
+        words += run;
+        full -= run;
+    }
+
+    // Symbols of a last, partly filled word one at a time
+    return rejected + count_packed_direct(words, count % PACKED_PER_WORD, counts);
+#endif
+}
+
+/*
+ * Name    : packed_counter_merge
+ * Purpose : Add what a packed counter has collected to a histogram and empty it again
+ * Input   : Counter, counts to add to (LETTER_RANGE entries)
+ * Outputs : counts updated, counter cleared
+ * Returns : Number of collected fields that are not a bin of the domain (not counted)
+ */
+size_t packed_counter_merge(packed_counter_t *counter, uint64_t *counts) {
+    size_t rejected = 0;
+
+#if PACKED_SYMBOL_BITS == 16
+    (void)counter;
+    (void)counts;
+#else
+    if (counter->pending == 0) {
+        return 0;
+    }
+
+    // Split each field into its symbols; values past the domain (corrupt input) are only counted as rejected
+    for (int value = 0; value < PACKED_TABLE_SIZE; value++) {
+        uint64_t total = 0;
+
+        for (int table = 0; table < PACKED_SUB_HISTOGRAMS; table++) {
+            total += counter->sub[table][value];
+        }
+        if (total == 0) {
+            continue;
+        }
+        for (int symbol = 0; symbol < PACKED_FIELD_SYMBOLS; symbol++) {
+            uint64_t bin = ((uint64_t)value >> (symbol * PACKED_SYMBOL_BITS)) & PACKED_MASK;
+
+            if (bin < LETTER_RANGE) {
+                counts[bin] += total;
+            } else {
+                rejected += (size_t)total;
+            }
+        }
+    }
+    memset(counter->sub, 0, sizeof(counter->sub));
+    counter->pending = 0;
+#endif
+    return rejected;
+}
+
+/*
+ * Name    : count_packed_letters
+ * Purpose : Add a batch of packed symbols (see PACKED_SYMBOL_BITS) to a histogram
+ * Input   : Packed words, number of symbols in them, counts to add to (LETTER_RANGE entries)
+ * Outputs : counts updated
+ * Returns : Number of fields that are not a bin of the domain (not counted)
+ */
+size_t count_packed_letters(const uint64_t *words, size_t count, uint64_t *counts) {
+#if PACKED_SYMBOL_BITS == 16
+    // Every 16-bit field is a bin, count straight into the histogram
+    return count_packed_direct(words, count, counts);
+#else
+    // Sub-histograms over whole fields; in the 5-bit domain a field is a pair of symbols, so a
+    // word costs 6 increments instead of 12 and the pair tables (4 x 1024) still fit in L1
+    packed_counter_t counter;
+    size_t rejected;
+
+    // DC counts one lane piece per call, often a few words: shift and mask those straight into counts
+    if (count < PACKED_MIN_LETTERS) {
+        return count_packed_direct(words, count, counts);
+    }
+
+    packed_counter_init(&counter);
+    rejected = packed_counter_add(&counter, words, count, counts);
+    return rejected + packed_counter_merge(&counter, counts);
+#endif
+}
@@ -0,0 +1,253 @@
+/*
+ * FILE: histogram_render.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the single-write histogram renderer. Every row is formatted into a fixed-size slot
+ * and compared with what is on screen; changed rows are appended to the frame behind a cursor
+ * move, and the frame ends by parking the cursor under the histogram and clearing the rest of
+ * the screen, so whatever the caller prints next replaces the previous frame's trailing output.
+ * When the output is not a terminal every frame is written in full, as the original display did.
+ */
+#define _POSIX_C_SOURCE 200809L  // Enables isatty
+
+#include "../inc/histogram_render.h"
+#include "../inc/common.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RENDER_ROW_SIZE (RENDER_MAX_BAR + 64)  /* Label, count and bar of one row */
+#define RENDER_ESCAPE_SIZE 16                  /* Cursor move and clear-to-end-of-line per row */
+
+/* Bins summed into one row (1 for A-T) and the resulting number of histogram rows */
+#define BINS_PER_ROW ((LETTER_RANGE + RENDER_MAX_ROWS - 1) / RENDER_MAX_ROWS)
+#define HISTOGRAM_ROWS ((LETTER_RANGE + BINS_PER_ROW - 1) / BINS_PER_ROW)
+
+/*
+ * Name    : approx_log2
+ * Purpose : Cheap monotonic log2 for bar lengths (exact at powers of two, linear in between)
+ * Input   : Value (at least 1)
+ * Outputs : None
+ * Returns : Approximate log2 of value
+ */
+static double approx_log2(uint64_t value) {
+    int msb = 63 - __builtin_clzll(value);
+
+    return msb + (double)(value - (1ULL << msb)) / (double)(1ULL << msb);
+}
+
+/*
+ * Name    : format_bar
+ * Purpose : Write one letter's bar in the renderer's mode
+ * Input   : Renderer, count, largest count in the frame, destination (RENDER_MAX_BAR + 2 bytes)
+ * Outputs : Bar text written
+ * Returns : Bar length
+ */
+static int format_bar(const histogram_renderer_t *renderer, uint64_t count, uint64_t max, char *bar) {
+    int length = 0;
+
+    if (renderer->bar_mode == BAR_MODE_CLASSIC) {
+        uint64_t hundreds = count / 100;
+        int tens = (int)(count % 100) / 10;
+        int ones = (int)(count % 10);
+
+        // Hundreds as '*', tens as '+', ones as '-', with '>' marking a bar that was cut off
+        for (uint64_t h = 0; h < hundreds && length < RENDER_MAX_BAR; h++) {
+            bar[length++] = '*';
+        }
+        for (int t = 0; t < tens && length < RENDER_MAX_BAR; t++) {
+            bar[length++] = '+';
+        }
+        for (int o = 0; o < ones && length < RENDER_MAX_BAR; o++) {
+            bar[length++] = '-';
+        }
+        if (hundreds + (uint64_t)tens + (uint64_t)ones > RENDER_MAX_BAR) {
+            bar[length++] = '>';
+        }
+    } else if (count > 0) {
+        double fraction = (renderer->bar_mode == BAR_MODE_LOG)
+                              ? approx_log2(count + 1) / approx_log2(max + 1)
+                              : (double)count / (double)max;
+
+        length = (int)(fraction * renderer->width + 0.5);
+        if (length == 0) {
+            length = 1;  // Any letter seen at all gets a mark
+        }
+        memset(bar, '*', (size_t)length);
+    }
+
+    bar[length] = '\0';
+    return length;
+}
+
+/*
+ * Name    : format_row
+ * Purpose : Format one row of the frame: a letter (or group of bins) with its count and bar, or the legend
+ * Input   : Renderer, row number, row counts, largest row count, destination (RENDER_ROW_SIZE bytes)
+ * Outputs : Row text written
+ * Returns : None
+ */
+static void format_row(const histogram_renderer_t *renderer, int row, const uint64_t *counts, uint64_t max,
+                       char *line) {
+    char bar[RENDER_MAX_BAR + 2];
+    char label[16];
+
+    if (row < HISTOGRAM_ROWS) {
+        int first = row * BINS_PER_ROW;
+        int length = format_symbol(label, sizeof(label), first);
+
+        if (BINS_PER_ROW > 1) {
+            int last = (first + BINS_PER_ROW - 1 < LETTER_RANGE) ? first + BINS_PER_ROW - 1 : LETTER_RANGE - 1;
+
+            label[length++] = '-';
+            format_symbol(label + length, (int)sizeof(label) - length, last);
+        }
+        format_bar(renderer, counts[row], max, bar);
+        snprintf(line, RENDER_ROW_SIZE, "%s-%03llu %s", label, (unsigned long long)counts[row], bar);
+    } else if (renderer->bar_mode == BAR_MODE_LOG) {
+        snprintf(line, RENDER_ROW_SIZE, "(log scale, full bar = %llu)", (unsigned long long)max);
+    } else if (renderer->bar_mode == BAR_MODE_AUTO) {
+        snprintf(line, RENDER_ROW_SIZE, "(* = %.1f letters)", max > 0 ? (double)max / renderer->width : 0.0);
+    } else {
+        snprintf(line, RENDER_ROW_SIZE, "(* = 100, + = 10, - = 1)");
+    }
+}
+
+/*
+ * Name    : renderer_init
+ * Purpose : Allocate the frame buffers and pick the output style
+ * Input   : Renderer, output descriptor, BAR_MODE_*, bar width for log/auto (1..RENDER_MAX_BAR)
+ * Outputs : Renderer ready for render_histogram
+ * Returns : 0 on success, -1 on invalid arguments or allocation failure
+ */
+int renderer_init(histogram_renderer_t *renderer, int fd, int bar_mode, int width) {
+    if (bar_mode < BAR_MODE_CLASSIC || bar_mode > BAR_MODE_AUTO || width <= 0 || width > RENDER_MAX_BAR) {
+        return -1;
+    }
+    renderer->fd = fd;
+    renderer->bar_mode = bar_mode;
+    renderer->width = width;
+    renderer->rows = HISTOGRAM_ROWS + 1;
+    renderer->use_cursor = isatty(fd);
+    renderer->screen_valid = 0;
+    renderer->frame = malloc((size_t)renderer->rows * (RENDER_ROW_SIZE + RENDER_ESCAPE_SIZE) + RENDER_ESCAPE_SIZE);
+    renderer->screen = calloc((size_t)renderer->rows, RENDER_ROW_SIZE);
+    if (renderer->frame == NULL || renderer->screen == NULL) {
+        renderer_free(renderer);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Name    : renderer_free
+ * Purpose : Release the frame buffers
+ * Input   : Renderer
+ * Outputs : Buffers freed
+ * Returns : None
+ */
+void renderer_free(histogram_renderer_t *renderer) {
+    free(renderer->frame);
+    free(renderer->screen);
+    renderer->frame = NULL;
+    renderer->screen = NULL;
+}
+
+/*
+ * Name    : renderer_invalidate
+ * Purpose : Force the next frame to be drawn in full (call after output that may have scrolled the screen)
+ * Input   : Renderer
+ * Outputs : screen_valid cleared
+ * Returns : None
+ */
+void renderer_invalidate(histogram_renderer_t *renderer) {
+    renderer->screen_valid = 0;
+}
+
+/*
+ * Name    : render_histogram
+ * Purpose : Draw the histogram with a single write, only the changed rows when possible
+ * Input   : Renderer, LETTER_RANGE counts
+ * Outputs : Frame written to the renderer's descriptor
+ * Returns : 0 on success, -1 if the write failed
+ */
+int render_histogram(histogram_renderer_t *renderer, const uint64_t *counts) {
+    int redraw_all = !renderer->use_cursor || !renderer->screen_valid;
+    char line[RENDER_ROW_SIZE];
+    uint64_t row_counts[HISTOGRAM_ROWS] = { 0 };
+    uint64_t max = 0;
+    size_t length = 0;
+
+    // Sum each row's bins (a copy when every bin has its own row), then find the longest bar
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        row_counts[i / BINS_PER_ROW] += counts[i];
+    }
+    for (int row = 0; row < HISTOGRAM_ROWS; row++) {
+        if (row_counts[row] > max) {
+            max = row_counts[row];
+        }
+    }
+
+    // A full frame starts on a cleared screen, as the original display did
+    if (redraw_all) {
+        length += (size_t)sprintf(renderer->frame + length, "\033[2J\033[H");
+    }
+    for (int row = 0; row < renderer->rows; row++) {
+        char *shown = renderer->screen + (size_t)row * RENDER_ROW_SIZE;
+
+        format_row(renderer, row, row_counts, max, line);
+        if (!redraw_all && strcmp(line, shown) == 0) {
+            continue;  // Unchanged on screen
+        }
+        if (renderer->use_cursor) {
+            length += (size_t)sprintf(renderer->frame + length, "\033[%d;1H%s\033[K", row + 1, line);
+        } else {
+            length += (size_t)sprintf(renderer->frame + length, "%s\n", line);
+        }
+        strcpy(shown, line);
+    }
+
+    // Park the cursor under the histogram and clear what the previous frame left below it
+    if (renderer->use_cursor) {
+        length += (size_t)sprintf(renderer->frame + length, "\033[%d;1H\033[J", renderer->rows + 1);
+    }
+
+    for (size_t written = 0; written < length;) {
+        ssize_t n = write(renderer->fd, renderer->frame + written, length - written);
+
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            renderer->screen_valid = 0;
+            return -1;
+        }
+        written += (size_t)n;
+    }
+    renderer->screen_valid = 1;
+    return 0;
+}
+
+/*
+ * Name    : parse_bar_mode
+ * Purpose : Convert a bar mode name to its constant
+ * Input   : "classic", "log" or "auto"
+ * Outputs : None
+ * Returns : BAR_MODE_* value, or -1 if the name is unknown
+ */
+int parse_bar_mode(const char *name) {
+    if (strcmp(name, "classic") == 0) {
+        return BAR_MODE_CLASSIC;
+    }
+    if (strcmp(name, "log") == 0) {
+        return BAR_MODE_LOG;
+    }
+    if (strcmp(name, "auto") == 0) {
+        return BAR_MODE_AUTO;
+    }
+    return -1;
+}
@@ -0,0 +1,124 @@
+/*
+ * FILE: latency_histogram.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the HDR-style latency histogram. A value v at or above LATENCY_SUB_BUCKETS has its
+ * top LATENCY_SUB_BUCKET_BITS bits kept as a mantissa in [S/2, S) and the rest as a shift e, and
+ * the bucket index is S + (e - 1) * S/2 + (mantissa - S/2). Percentiles report the highest value
+ * a bucket can hold (capped at the exact maximum), as HdrHistogram does.
+ */
+#include "../inc/latency_histogram.h"
+#include <string.h>
+
+#define HALF_SUB_BUCKETS (LATENCY_SUB_BUCKETS / 2)
+
+/*
+ * Name    : bucket_of
+ * Purpose : Bucket index of a value
+ * Input   : Value
+ * Outputs : None
+ * Returns : Index into counts
+ */
+static inline int bucket_of(uint64_t value) {
+    int shift;
+
+    if (value < LATENCY_SUB_BUCKETS) {
+        return (int)value;
+    }
+    shift = (63 - __builtin_clzll(value)) - LATENCY_SUB_BUCKET_BITS + 1;
+    return LATENCY_SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + (int)((value >> shift) - HALF_SUB_BUCKETS);
+}
+
+/*
+ * Name    : bucket_highest
+ * Purpose : Largest value that falls into a bucket
+ * Input   : Bucket index
+ * Outputs : None
+ * Returns : Highest equivalent value
+ */
+static uint64_t bucket_highest(int bucket) {
+    int shift;
+    uint64_t mantissa;
+
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+    shift = (bucket - LATENCY_SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+    mantissa = (uint64_t)((bucket - LATENCY_SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS);
+    return (mantissa << shift) + ((1ULL << shift) - 1);
+}
+
+/*
+ * Name    : latency_reset
+ * Purpose : Empty a histogram
+ * Input   : Pointer to histogram
+ * Outputs : Histogram cleared
+ * Returns : None
+ */
+void latency_reset(latency_histogram_t *histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+/*
+ * Name    : latency_record
+ * Purpose : Add one value
+ * Input   : Pointer to histogram, value (ns)
+ * Outputs : Histogram updated
+ * Returns : None
+ */
+void latency_record(latency_histogram_t *histogram, uint64_t value) {
+    histogram->counts[bucket_of(value)]++;
+    histogram->total++;
+    histogram->sum += value;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+/*
+ * Name    : latency_percentile
+ * Purpose : Value at a percentile
+ * Input   : Pointer to histogram, percentile (0..100, e.g. 99.9)
+ * Outputs : None
+ * Returns : Highest value of the bucket holding that percentile (never above the maximum), 0 if empty
+ */
+uint64_t latency_percentile(const latency_histogram_t *histogram, double percentile) {
+    uint64_t rank;
+    uint64_t seen = 0;
+
+    if (histogram->total == 0) {
+        return 0;
+    }
+
+    // Rank of the value we want, 1-based: the smallest count covering the percentile
+    rank = (uint64_t)(percentile / 100.0 * (double)histogram->total + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > histogram->total) {
+        rank = histogram->total;
+    }
+
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            uint64_t highest = bucket_highest(bucket);
+
+            return (highest < histogram->max) ? highest : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/*
+ * Name    : latency_mean
+ * Purpose : Mean of the recorded values
+ * Input   : Pointer to histogram
+ * Outputs : None
+ * Returns : Mean, 0 if empty
+ */
+double latency_mean(const latency_histogram_t *histogram) {
+    return (histogram->total > 0) ? (double)histogram->sum / (double)histogram->total : 0.0;
+}
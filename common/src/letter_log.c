@@ -0,0 +1,249 @@
+/*
+ * FILE: letter_log.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the letter log (see letter_log.h). The writer only ever appends: a log that already
+ * exists is continued (block offsets keep counting from its original start, so a gap between two
+ * recording runs replays as a pause), and a file that is not a log of this domain is refused
+ * rather than overwritten. Letters are buffered until a block is full or a tick old, so a caller
+ * handing over a few letters at a time costs one memcpy and one clock read per call.
+ */
+#define _POSIX_C_SOURCE 200809L  // Enables clock_gettime
+
+#include "../inc/letter_log.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * Name    : unix_time_ns
+ * Purpose : Wall-clock time, which stays meaningful across recording runs
+ * Input   : None
+ * Outputs : None
+ * Returns : CLOCK_REALTIME in nanoseconds
+ */
+static int64_t unix_time_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Name    : header_matches
+ * Purpose : Check a log header was written for this build's domain and packing
+ * Input   : Header
+ * Outputs : None
+ * Returns : 1 if it matches
+ */
+static int header_matches(const letter_log_header_t *header) {
+    return header->magic == LETTER_LOG_MAGIC && header->version == LETTER_LOG_VERSION &&
+           header->symbol_bins == LETTER_RANGE && header->bits_per_symbol == LETTER_LOG_BITS;
+}
+
+/*
+ * Name    : write_block
+ * Purpose : Pack the pending letters and append them as one block
+ * Input   : Writer
+ * Outputs : Block appended, pending letters cleared
+ * Returns : None
+ */
+static void write_block(letter_log_writer_t *writer) {
+    uint64_t words[LETTER_LOG_BLOCK_WORDS];
+    letter_log_block_header_t block;
+    int word_count = (writer->pending_count + LETTER_LOG_PER_WORD - 1) / LETTER_LOG_PER_WORD;
+
+    if (writer->pending_count == 0) {
+        return;
+    }
+    memset(words, 0, (size_t)word_count * sizeof(uint64_t));
+    for (int i = 0; i < writer->pending_count; i++) {
+        uint64_t symbol = (uint64_t)(writer->pending[i] - MIN_LETTER) & LETTER_LOG_MASK;
+
+        words[i / LETTER_LOG_PER_WORD] |= symbol << ((i % LETTER_LOG_PER_WORD) * LETTER_LOG_BITS);
+    }
+
+    block.offset_ns = writer->block_offset_ns;
+    block.count = (uint32_t)writer->pending_count;
+    block.reserved = 0;
+    if (fwrite(&block, sizeof(block), 1, writer->file) != 1 ||
+        fwrite(words, sizeof(uint64_t), (size_t)word_count, writer->file) != (size_t)word_count) {
+        perror("letter_log: write");
+    }
+    writer->letters += (uint64_t)writer->pending_count;
+    writer->bytes += sizeof(block) + (uint64_t)word_count * sizeof(uint64_t);
+    writer->pending_count = 0;
+}
+
+/*
+ * Name    : letter_log_create
+ * Purpose : Open a log for appending, creating it (with its header) if it does not exist
+ * Input   : Writer, file path
+ * Outputs : Writer ready
+ * Returns : 0 on success, -1 if the file cannot be opened or is not a log of this domain
+ */
+int letter_log_create(letter_log_writer_t *writer, const char *path) {
+    letter_log_header_t header;
+    FILE *existing;
+
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "ab");
+    if (writer->file == NULL) {
+        perror("letter_log: open");
+        return -1;
+    }
+
+    if (ftell(writer->file) == 0) {
+        // New log
+        memset(&header, 0, sizeof(header));
+        header.magic = LETTER_LOG_MAGIC;
+        header.version = LETTER_LOG_VERSION;
+        header.symbol_bins = LETTER_RANGE;
+        header.bits_per_symbol = LETTER_LOG_BITS;
+        header.start_unix_ns = unix_time_ns();
+        if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+            perror("letter_log: write header");
+            fclose(writer->file);
+            return -1;
+        }
+        writer->bytes = sizeof(header);
+    } else {
+        // Existing log: continue it, but only if it is one of ours
+        existing = fopen(path, "rb");
+        if (existing == NULL || fread(&header, sizeof(header), 1, existing) != 1 || !header_matches(&header)) {
+            fprintf(stderr, "letter_log: %s is not a letter log of this symbol domain, not appending\n", path);
+            if (existing != NULL) {
+                fclose(existing);
+            }
+            fclose(writer->file);
+            return -1;
+        }
+        fclose(existing);
+    }
+    writer->start_unix_ns = header.start_unix_ns;
+    return 0;
+}
+
+/*
+ * Name    : letter_log_append
+ * Purpose : Record a batch of letters
+ * Input   : Writer (NULL when not recording), letters, number of letters
+ * Outputs : Letters buffered; full or tick-old blocks appended to the file
+ * Returns : None
+ */
+void letter_log_append(letter_log_writer_t *writer, const symbol_t *letters, int count) {
+    int64_t offset_ns;
+
+    if (writer == NULL || count <= 0) {
+        return;
+    }
+    offset_ns = unix_time_ns() - writer->start_unix_ns;
+    if (writer->pending_count > 0 && offset_ns - writer->block_offset_ns >= LETTER_LOG_TICK_NS) {
+        write_block(writer);
+    }
+
+    while (count > 0) {
+        int room = LETTER_LOG_BLOCK_LETTERS - writer->pending_count;
+        int take = (count < room) ? count : room;
+
+        if (writer->pending_count == 0) {
+            writer->block_offset_ns = offset_ns;
+        }
+        memcpy(writer->pending + writer->pending_count, letters, (size_t)take * sizeof(symbol_t));
+        writer->pending_count += take;
+        letters += take;
+        count -= take;
+        if (writer->pending_count == LETTER_LOG_BLOCK_LETTERS) {
+            write_block(writer);
+        }
+    }
+}
+
+/*
+ * Name    : letter_log_close
+ * Purpose : Append the last partial block and close the log
+ * Input   : Writer (NULL when not recording)
+ * Outputs : File complete and closed
+ * Returns : None
+ */
+void letter_log_close(letter_log_writer_t *writer) {
+    if (writer == NULL || writer->file == NULL) {
+        return;
+    }
+    write_block(writer);
+    fclose(writer->file);
+    writer->file = NULL;
+}
+
+/*
+ * Name    : letter_log_open
+ * Purpose : Open a log for replay and check it was recorded for this build's domain
+ * Input   : Reader, file path
+ * Outputs : Reader positioned at the first block
+ * Returns : 0 on success, -1 if the file cannot be read or does not match
+ */
+int letter_log_open(letter_log_reader_t *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (reader->file == NULL) {
+        perror("letter_log: open");
+        return -1;
+    }
+    if (fread(&reader->header, sizeof(reader->header), 1, reader->file) != 1 ||
+        !header_matches(&reader->header)) {
+        fprintf(stderr, "letter_log: %s is not a letter log of this symbol domain\n", path);
+        fclose(reader->file);
+        reader->file = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Name    : letter_log_next
+ * Purpose : Read and unpack the next block
+ * Input   : Reader
+ * Outputs : offset_ns, count and letters of the reader set to the block
+ * Returns : Letters in the block, 0 at the end of the log, -1 if the log is truncated or corrupt
+ */
+int letter_log_next(letter_log_reader_t *reader) {
+    uint64_t words[LETTER_LOG_BLOCK_WORDS];
+    letter_log_block_header_t block;
+    int word_count;
+
+    if (fread(&block, sizeof(block), 1, reader->file) != 1) {
+        return feof(reader->file) ? 0 : -1;
+    }
+    if (block.count == 0 || block.count > LETTER_LOG_BLOCK_LETTERS) {
+        return -1;
+    }
+    word_count = ((int)block.count + LETTER_LOG_PER_WORD - 1) / LETTER_LOG_PER_WORD;
+    if (fread(words, sizeof(uint64_t), (size_t)word_count, reader->file) != (size_t)word_count) {
+        return -1;
+    }
+
+    for (int i = 0; i < (int)block.count; i++) {
+        uint64_t symbol = (words[i / LETTER_LOG_PER_WORD] >> ((i % LETTER_LOG_PER_WORD) * LETTER_LOG_BITS)) &
+                          LETTER_LOG_MASK;
+
+        reader->letters[i] = (symbol_t)(MIN_LETTER + symbol);
+    }
+    reader->offset_ns = block.offset_ns;
+    reader->count = (int)block.count;
+    return reader->count;
+}
+
+/*
+ * Name    : letter_log_close_reader
+ * Purpose : Close a log opened for replay
+ * Input   : Reader
+ * Outputs : File closed
+ * Returns : None
+ */
+void letter_log_close_reader(letter_log_reader_t *reader) {
+    if (reader->file != NULL) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ * FILE: pacer.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the drift-free token bucket pacer. Deadlines advance by exactly one tick from
+ * the previous deadline rather than from the time we woke up, and the bucket keeps the
+ * fractional letters, so the long-run rate matches the target exactly. A producer that falls
+ * more than PACER_MAX_LAG_TICKS behind (e.g. blocked on a full ring) restarts from now instead
+ * of emitting the whole backlog as one burst; the lost time shows up in the achieved rate.
+ */
+#define _POSIX_C_SOURCE 200809L  // Enables clock_nanosleep
+
+#include "../inc/pacer.h"
+#include <errno.h>
+
+#define NSEC_PER_SEC 1000000000L
+
+/*
+ * Name    : timespec_add_ns
+ * Purpose : Advance a timespec by a number of nanoseconds
+ * Input   : Timespec to advance, nanoseconds
+ * Outputs : ts updated and normalised
+ * Returns : None
+ */
+static void timespec_add_ns(struct timespec *ts, int64_t ns) {
+    ts->tv_sec += (time_t)(ns / NSEC_PER_SEC);
+    ts->tv_nsec += (long)(ns % NSEC_PER_SEC);
+    if (ts->tv_nsec >= NSEC_PER_SEC) {
+        ts->tv_sec++;
+        ts->tv_nsec -= NSEC_PER_SEC;
+    }
+}
+
+/*
+ * Name    : timespec_diff_ns
+ * Purpose : Nanoseconds from one timespec to another
+ * Input   : Earlier and later timespecs
+ * Outputs : None
+ * Returns : later - earlier in nanoseconds (negative if later is before earlier)
+ */
+static int64_t timespec_diff_ns(const struct timespec *earlier, const struct timespec *later) {
+    return (int64_t)(later->tv_sec - earlier->tv_sec) * NSEC_PER_SEC + (later->tv_nsec - earlier->tv_nsec);
+}
+
+/*
+ * Name    : pacer_init
+ * Purpose : Set up a pacer for a target rate; the first deadline is now
+ * Input   : Pointer to pacer, target letters per second, preferred letters per tick at slow rates
+ * Outputs : Pacer initialized
+ * Returns : Most letters one pacer_wait can return (size the producer's batch buffer with it),
+ *           or -1 if the rate or batch size is not positive
+ */
+int pacer_init(pacer_t *pacer, double rate, int batch_size) {
+    double batch_ns;
+
+    if (rate <= 0 || batch_size <= 0) {
+        return -1;
+    }
+
+    // One batch per tick while that is slower than the minimum tick, otherwise batch up per tick
+    batch_ns = (double)batch_size / rate * NSEC_PER_SEC;
+    pacer->rate = rate;
+    pacer->tick_ns = (batch_ns > PACER_MIN_TICK_NS) ? (int64_t)batch_ns : PACER_MIN_TICK_NS;
+    pacer->tokens_per_tick = rate * (double)pacer->tick_ns / NSEC_PER_SEC;
+    pacer->max_emit = (int)pacer->tokens_per_tick;
+    if (pacer->max_emit < pacer->tokens_per_tick) {
+        pacer->max_emit++;  // Round up so the fractional letters can still be emitted
+    }
+    pacer->tokens = 0;
+    pacer->emitted = 0;
+    pacer->skipped_ticks = 0;
+    clock_gettime(CLOCK_MONOTONIC, &pacer->start);
+    pacer->next = pacer->start;
+    return pacer->max_emit;
+}
+
+/*
+ * Name    : pacer_wait
+ * Purpose : Sleep until the next deadline and take the letters earned during that tick
+ * Input   : Pointer to pacer
+ * Outputs : Deadline advanced, tokens consumed, emitted updated
+ * Returns : Letters to emit now (0 .. max_emit), or -1 if a signal interrupted the sleep
+ */
+int pacer_wait(pacer_t *pacer) {
+    struct timespec now;
+    int count;
+    int rc;
+
+    rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &pacer->next, NULL);
+    if (rc == EINTR) {
+        return -1;  // Let the caller check its running flag, the deadline is kept
+    }
+
+    // Too far behind: abandon the missed ticks rather than bursting them out
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (timespec_diff_ns(&pacer->next, &now) > PACER_MAX_LAG_TICKS * pacer->tick_ns) {
+        pacer->skipped_ticks += (uint64_t)(timespec_diff_ns(&pacer->next, &now) / pacer->tick_ns);
+        pacer->next = now;
+    }
+    timespec_add_ns(&pacer->next, pacer->tick_ns);
+
+    pacer->tokens += pacer->tokens_per_tick;
+    if (pacer->tokens > pacer->max_emit) {
+        pacer->tokens = pacer->max_emit;
+    }
+    count = (int)pacer->tokens;
+    pacer->tokens -= count;
+    pacer->emitted += (uint64_t)count;
+    return count;
+}
+
+/*
+ * Name    : pacer_elapsed_ns
+ * Purpose : Time since the pacer was started
+ * Input   : Pointer to pacer
+ * Outputs : None
+ * Returns : Elapsed nanoseconds
+ */
+int64_t pacer_elapsed_ns(const pacer_t *pacer) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_diff_ns(&pacer->start, &now);
+}
+
+/*
+ * Name    : pacer_achieved_rate
+ * Purpose : Letters actually handed out per second since the pacer started
+ * Input   : Pointer to pacer
+ * Outputs : None
+ * Returns : Achieved letters per second (0 before any time has passed)
+ */
+double pacer_achieved_rate(const pacer_t *pacer) {
+    int64_t elapsed = pacer_elapsed_ns(pacer);
+
+    return (elapsed > 0) ? (double)pacer->emitted * NSEC_PER_SEC / (double)elapsed : 0.0;
+}
@@ -0,0 +1,119 @@
+/*
+ * FILE: producer_registry.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the producer registry in shared memory. Slots are claimed with a
+ * compare-and-swap on their state, so producers can start in any order and never
+ * share a slot or a lane.
+ */
+#define _POSIX_C_SOURCE 200809L  // Enables kill
+
+#include "../inc/producer_registry.h"
+#include "../inc/circular_buffer.h"
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+
+/*
+ * Name    : register_producer
+ * Purpose : Claim the first free registry slot (and its lane) for the calling process
+ * Input   : Pointer to shared memory, overflow policy, letters per write, target letters per second
+ * Outputs : Slot filled in and marked active, this process's semaphore waits counted in the slot
+ * Returns : Slot (lane) number, or -1 if every lane is taken
+ */
+int register_producer(shared_memory_t *shm, int policy, int batch_size, double rate) {
+    for (int slot = 0; slot < (int)shm->header.lane_count; slot++) {
+        producer_slot_t *producer = &shm->producers[slot];
+        int expected = SLOT_FREE;
+
+        if (atomic_compare_exchange_strong(&producer->state, &expected, SLOT_ACTIVE)) {
+            producer->pid = getpid();
+            producer->policy = policy;
+            producer->batch_size = batch_size;
+            producer->rate = rate;
+            ring_track_lock_wait(&producer->lock_wait_ns);
+            return slot;
+        }
+    }
+
+    fprintf(stderr, "register_producer: all %u lanes are taken\n", shm->header.lane_count);
+    return -1;
+}
+
+/*
+ * Name    : unregister_producer
+ * Purpose : Mark a producer's slot as exited, keeping its counters for DC's final report
+ * Input   : Pointer to shared memory, slot number
+ * Outputs : Slot state updated
+ * Returns : None
+ */
+void unregister_producer(shared_memory_t *shm, int slot) {
+    if (slot >= 0 && slot < MAX_PRODUCERS) {
+        atomic_store(&shm->producers[slot].state, SLOT_EXITED);
+    }
+}
+
+/*
+ * Name    : record_producer_pacing
+ * Purpose : Publish a producer's pacer progress (only ever called by the slot's owner)
+ * Input   : Pointer to shared memory, slot number, letters emitted, nanoseconds since pacing started
+ * Outputs : Slot's emitted and paced_ns updated
+ * Returns : None
+ */
+void record_producer_pacing(shared_memory_t *shm, int slot, uint64_t emitted, int64_t elapsed_ns) {
+    if (slot >= 0 && slot < MAX_PRODUCERS) {
+        atomic_store_explicit(&shm->producers[slot].emitted, emitted, memory_order_relaxed);
+        atomic_store_explicit(&shm->producers[slot].paced_ns, (uint64_t)elapsed_ns, memory_order_relaxed);
+    }
+}
+
+/*
+ * Name    : producer_achieved_rate
+ * Purpose : Letters per second a producer's pacer actually released
+ * Input   : Pointer to a registry slot
+ * Outputs : None
+ * Returns : Achieved rate, 0 until the producer has published any progress
+ */
+double producer_achieved_rate(const producer_slot_t *producer) {
+    uint64_t emitted = atomic_load_explicit(&producer->emitted, memory_order_relaxed);
+    uint64_t paced_ns = atomic_load_explicit(&producer->paced_ns, memory_order_relaxed);
+
+    return (paced_ns > 0) ? (double)emitted * 1e9 / (double)paced_ns : 0.0;
+}
+
+/*
+ * Name    : count_active_producers
+ * Purpose : Count producers that are still running
+ * Input   : Pointer to shared memory
+ * Outputs : None
+ * Returns : Number of active slots
+ */
+int count_active_producers(shared_memory_t *shm) {
+    int active = 0;
+
+    for (int slot = 0; slot < MAX_PRODUCERS; slot++) {
+        if (atomic_load(&shm->producers[slot].state) == SLOT_ACTIVE) {
+            active++;
+        }
+    }
+    return active;
+}
+
+/*
+ * Name    : signal_producers
+ * Purpose : Send a signal to every active producer (async-signal-safe, used from DC's SIGINT handler)
+ * Input   : Pointer to shared memory, signal number
+ * Outputs : Signal delivered to each registered producer
+ * Returns : None
+ */
+void signal_producers(shared_memory_t *shm, int signum) {
+    for (int slot = 0; slot < MAX_PRODUCERS; slot++) {
+        producer_slot_t *producer = &shm->producers[slot];
+
+        if (atomic_load(&producer->state) == SLOT_ACTIVE && producer->pid > 0) {
+            kill(producer->pid, signum);
+        }
+    }
+}
@@ -0,0 +1,146 @@
+/*
+ * FILE: ring_stats.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the consumer side of the runtime statistics and their collection. Producers update
+ * their counters in circular_buffer.c as they write; DC calls the consumer_stats_* functions once
+ * per read pass, not per letter.
+ */
+#define _POSIX_C_SOURCE 200809L  // Enables clock_gettime
+
+#include "../inc/ring_stats.h"
+#include "../inc/circular_buffer.h"
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Name    : monotonic_ns
+ * Purpose : Current CLOCK_MONOTONIC time, the clock every process's statistics use
+ * Input   : None
+ * Outputs : None
+ * Returns : Nanoseconds
+ */
+uint64_t monotonic_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * Name    : counter_add
+ * Purpose : Add to a counter only the calling process writes (no read-modify-write needed)
+ * Input   : Counter, amount
+ * Outputs : Counter updated
+ * Returns : None
+ */
+static inline void counter_add(_Atomic uint64_t *counter, uint64_t amount) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+/*
+ * Name    : consumer_stats_attach
+ * Purpose : Claim the consumer block for the calling DC and count its semaphore waits there
+ * Input   : Pointer to shared memory
+ * Outputs : Block reset and marked attached
+ * Returns : None
+ */
+void consumer_stats_attach(shared_memory_t *shm) {
+    consumer_stats_t *consumer = &shm->consumer;
+
+    consumer->pid = getpid();
+    atomic_store_explicit(&consumer->consumed, 0, memory_order_relaxed);
+    atomic_store_explicit(&consumer->drains, 0, memory_order_relaxed);
+    atomic_store_explicit(&consumer->wakeups, 0, memory_order_relaxed);
+    atomic_store_explicit(&consumer->lock_wait_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&consumer->last_drain_ns, monotonic_ns(), memory_order_relaxed);
+    atomic_store(&consumer->attached, 1);
+    ring_track_lock_wait(&consumer->lock_wait_ns);
+}
+
+/*
+ * Name    : consumer_stats_detach
+ * Purpose : Mark the consumer gone, keeping its counters
+ * Input   : Pointer to shared memory
+ * Outputs : Block marked detached
+ * Returns : None
+ */
+void consumer_stats_detach(shared_memory_t *shm) {
+    ring_track_lock_wait(NULL);
+    atomic_store(&shm->consumer.attached, 0);
+}
+
+/*
+ * Name    : consumer_stats_drain
+ * Purpose : Account for one read pass of DC
+ * Input   : Pointer to shared memory, letters (records) read
+ * Outputs : consumed, drains and last_drain_ns updated
+ * Returns : None
+ */
+void consumer_stats_drain(shared_memory_t *shm, int consumed) {
+    consumer_stats_t *consumer = &shm->consumer;
+
+    counter_add(&consumer->consumed, (uint64_t)consumed);
+    counter_add(&consumer->drains, 1);
+    atomic_store_explicit(&consumer->last_drain_ns, monotonic_ns(), memory_order_relaxed);
+}
+
+/*
+ * Name    : consumer_stats_wakeup
+ * Purpose : Account for one futex wakeup of DC
+ * Input   : Pointer to shared memory
+ * Outputs : wakeups updated
+ * Returns : None
+ */
+void consumer_stats_wakeup(shared_memory_t *shm) {
+    counter_add(&shm->consumer.wakeups, 1);
+}
+
+/*
+ * Name    : collect_ring_stats
+ * Purpose : Sum every producer's counters, DC's counters and the lanes' occupancy (read-only)
+ * Input   : Pointer to shared memory (may be attached read-only), where to store the totals
+ * Outputs : stats filled in
+ * Returns : None
+ */
+void collect_ring_stats(const shared_memory_t *shm, ring_stats_t *stats) {
+    const consumer_stats_t *consumer = &shm->consumer;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->taken_ns = monotonic_ns();
+
+    for (int slot = 0; slot < MAX_PRODUCERS; slot++) {
+        const producer_slot_t *producer = &shm->producers[slot];
+        int state = atomic_load_explicit(&producer->state, memory_order_acquire);
+
+        if (state == SLOT_FREE) {
+            continue;
+        }
+        stats->active_producers += (state == SLOT_ACTIVE);
+        stats->written += atomic_load_explicit(&producer->written, memory_order_relaxed);
+        stats->dropped += atomic_load_explicit(&producer->dropped, memory_order_relaxed);
+        stats->overwritten += atomic_load_explicit(&producer->overwritten, memory_order_relaxed);
+        stats->blocked_ns += atomic_load_explicit(&producer->blocked_ns, memory_order_relaxed);
+        stats->producer_lock_ns += atomic_load_explicit(&producer->lock_wait_ns, memory_order_relaxed);
+    }
+
+    stats->consumer_attached = atomic_load_explicit(&consumer->attached, memory_order_acquire);
+    stats->consumed = atomic_load_explicit(&consumer->consumed, memory_order_relaxed);
+    stats->drains = atomic_load_explicit(&consumer->drains, memory_order_relaxed);
+    stats->wakeups = atomic_load_explicit(&consumer->wakeups, memory_order_relaxed);
+    stats->consumer_lock_ns = atomic_load_explicit(&consumer->lock_wait_ns, memory_order_relaxed);
+    stats->last_drain_ns = atomic_load_explicit(&consumer->last_drain_ns, memory_order_relaxed);
+
+    // Read index first: a write index loaded after it is never behind it
+    for (uint32_t lane = 0; lane < shm->header.lane_count; lane++) {
+        uint64_t read = atomic_load_explicit(&shm->lanes[lane].read_index, memory_order_acquire);
+        uint64_t write = atomic_load_explicit(&shm->lanes[lane].write_index, memory_order_acquire);
+
+        stats->used += (write > read) ? write - read : 0;
+    }
+    stats->capacity = (uint64_t)shm->header.lane_count * lane_capacity(shm);
+}
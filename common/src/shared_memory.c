@@ -8,6 +8,7 @@
  * between producer and consumer processes.
  */
 #include "../inc/shared_memory.h"
+#include "../inc/common.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,44 +17,140 @@
 #include <sys/shm.h>
 
 /*
- * Name    : create_shared_memory
- * Purpose : Creates shared memory or attaches to existing one
- * Input   : None
+ * Name    : shm_segment_size
+ * Purpose : Compute the total segment size for a lane capacity and lane count
+ * Input   : Lane capacity in symbols, number of lanes
  * Outputs : None
+ * Returns : Header plus data region size in bytes
+ */
+size_t shm_segment_size(uint64_t capacity, int lane_count) {
+    return offsetof(shared_memory_t, buffer) + (size_t)capacity * (size_t)lane_count * sizeof(symbol_t);
+}
+
+/*
+ * Name    : create_shared_memory
+ * Purpose : Creates shared memory (replacing a stale segment of another size) and stamps its header
+ * Input   : Lane capacity in symbols (power of two between MIN_BUFFER_SIZE and MAX_BUFFER_SIZE),
+ *           number of lanes (1..MAX_PRODUCERS)
+ * Outputs : Header of the segment written
  * Returns : Shared memory ID or -1 on error
  */
-int create_shared_memory() {
+int create_shared_memory(uint64_t capacity, int lane_count) {
     int shmid;
+    size_t size = shm_segment_size(capacity, lane_count);
+    struct shmid_ds info;
+    shared_memory_t *shm;
+
+    if (capacity < MIN_BUFFER_SIZE || capacity > MAX_BUFFER_SIZE || (capacity & (capacity - 1)) != 0) {
+        fprintf(stderr, "create_shared_memory: capacity %llu is not a power of two in range\n",
+                (unsigned long long)capacity);
+        return -1;
+    }
+    if (lane_count < 1 || lane_count > MAX_PRODUCERS) {
+        fprintf(stderr, "create_shared_memory: lane count %d is not between 1 and %d\n", lane_count, MAX_PRODUCERS);
+        return -1;
+    }
     
     /* Try to create shared memory */
-    shmid = shmget(SHM_KEY, sizeof(shared_memory_t), IPC_CREAT | IPC_EXCL | 0666);
-    if (shmid != -1) {
-        /* Created new shared memory */
-        return shmid;
-    } else if (errno == EEXIST) {
-        /* Shared memory already exists, get the ID */
-        return shmget(SHM_KEY, sizeof(shared_memory_t), 0666);
-    } else {
+    shmid = shmget(SHM_KEY, size, IPC_CREAT | IPC_EXCL | 0666);
+    if (shmid == -1 && errno == EEXIST) {
+        /* Shared memory already exists, reuse it only if it has the size we need */
+        shmid = shmget(SHM_KEY, 0, 0666);
+        if (shmid != -1 && shmctl(shmid, IPC_STAT, &info) == 0 && info.shm_segsz != size) {
+            remove_shared_memory(shmid);
+            shmid = shmget(SHM_KEY, size, IPC_CREAT | IPC_EXCL | 0666);
+        }
+    }
+    if (shmid == -1) {
         /* Error creating shared memory */
         perror("shmget");
         return -1;
     }
+
+    /* Stamp the header so attach_shared_memory can validate it */
+    shm = (shared_memory_t *)shmat(shmid, NULL, 0);
+    if (shm == (shared_memory_t *)-1) {
+        perror("shmat");
+        return -1;
+    }
+    shm->header.magic = SHM_MAGIC;
+    shm->header.version = SHM_LAYOUT_VERSION;
+    shm->header.capacity = capacity;
+    shm->header.mask = capacity - 1;
+    shm->header.lane_count = (uint32_t)lane_count;
+    shm->header.symbol_bins = LETTER_RANGE;
+    shm->header.data_offset = offsetof(shared_memory_t, buffer);
+    shm->header.segment_size = size;
+    shmdt(shm);
+
+    return shmid;
+}
+
+/*
+ * Name    : attach_segment
+ * Purpose : Attaches process to shared memory segment and validates its header
+ * Input   : Shared memory ID, shmat flags (0 or SHM_RDONLY)
+ * Outputs : None
+ * Returns : Attached segment, or NULL on failure (including a segment built with a different layout)
+ */
+static shared_memory_t *attach_segment(int shmid, int flags) {
+    struct shmid_ds info;
+    shared_memory_t *shm;
+    const shm_header_t *header;
+
+    if (shmctl(shmid, IPC_STAT, &info) == -1) {
+        perror("shmctl");
+        return NULL;
+    }
+    if (info.shm_segsz < sizeof(shared_memory_t)) {
+        fprintf(stderr, "attach_shared_memory: segment too small (%zu bytes)\n", (size_t)info.shm_segsz);
+        return NULL;
+    }
+
+    shm = (shared_memory_t *)shmat(shmid, NULL, flags);
+    if (shm == (shared_memory_t *)-1) {
+        perror("shmat");
+        return NULL;
+    }
+
+    /* Refuse segments created by a mismatched binary instead of corrupting them */
+    header = &shm->header;
+    if (header->magic != SHM_MAGIC || header->version != SHM_LAYOUT_VERSION ||
+        header->data_offset != offsetof(shared_memory_t, buffer) ||
+        header->mask != header->capacity - 1 ||
+        header->lane_count < 1 || header->lane_count > MAX_PRODUCERS || header->symbol_bins != LETTER_RANGE ||
+        header->segment_size != shm_segment_size(header->capacity, (int)header->lane_count) ||
+        header->segment_size > info.shm_segsz) {
+        fprintf(stderr, "attach_shared_memory: header mismatch (magic 0x%x, version %u, expected version %u)\n",
+                header->magic, header->version, SHM_LAYOUT_VERSION);
+        shmdt(shm);
+        return NULL;
+    }
+    return shm;
 }
 
 /*
  * Name    : attach_shared_memory
- * Purpose : Attaches process to shared memory segment
+ * Purpose : Attaches process to shared memory segment and validates its header
  * Input   : Shared memory ID, double pointer to shared_memory_t
  * Outputs : shm pointer initialized
- * Returns : 0 on success, -1 on failure
+ * Returns : 0 on success, -1 on failure (including a segment built with a different layout)
  */
 int attach_shared_memory(int shmid, shared_memory_t **shm) {
-    *shm = (shared_memory_t *)shmat(shmid, NULL, 0);
-    if (*shm == (shared_memory_t *)-1) {
-        perror("shmat");
-        return -1;
-    }
-    return 0;
+    *shm = attach_segment(shmid, 0);
+    return (*shm != NULL) ? 0 : -1;
+}
+
+/*
+ * Name    : attach_shared_memory_readonly
+ * Purpose : Attaches a monitor read-only, so it can never disturb the ring
+ * Input   : Shared memory ID, double pointer to shared_memory_t
+ * Outputs : shm pointer initialized
+ * Returns : 0 on success, -1 on failure (including a segment built with a different layout)
+ */
+int attach_shared_memory_readonly(int shmid, const shared_memory_t **shm) {
+    *shm = attach_segment(shmid, SHM_RDONLY);
+    return (*shm != NULL) ? 0 : -1;
 }
 
 /*
@@ -63,7 +160,7 @@ int attach_shared_memory(int shmid, shared_memory_t **shm) {
  * Outputs : None
  * Returns : None
  */
-void detach_shared_memory(shared_memory_t *shm) {
+void detach_shared_memory(const shared_memory_t *shm) {
     if (shm != NULL) {
         shmdt(shm);
     }
@@ -82,13 +179,59 @@ void remove_shared_memory(int shmid) {
 
 /*
  * Name    : init_shared_memory
- * Purpose : Initializes the buffer and indices to default state
- * Input   : Pointer to shared memory
- * Outputs : Buffer zeroed, indices reset
+ * Purpose : Initializes the lane indices, ring mode, ring format and producer slots to default state
+ * Input   : Pointer to shared memory, ring mode (RING_MODE_LOCKFREE or RING_MODE_SEMAPHORE),
+ *           ring format (RING_FORMAT_SYMBOLS, RING_FORMAT_RECORDS or RING_FORMAT_PACKED)
+ * Outputs : Indices reset (the data region is never read before it is written, so it is not cleared)
  * Returns : None
  */
-void init_shared_memory(shared_memory_t *shm) {
-    memset(shm->buffer, 0, BUFFER_SIZE);
-    shm->read_index = 0;
-    shm->write_index = 0;
-}  
\ No newline at end of file
+void init_shared_memory(shared_memory_t *shm, int ring_mode, int ring_format) {
+    for (int i = 0; i < MAX_PRODUCERS; i++) {
+        ring_lane_t *lane = &shm->lanes[i];
+
+        atomic_init(&lane->write_index, 0);
+        lane->cached_read_index = 0;
+        atomic_init(&lane->space_futex, 0);
+        atomic_init(&lane->producer_waiting, 0);
+        atomic_init(&lane->read_index, 0);
+        lane->cached_write_index = 0;
+    }
+    atomic_init(&shm->data_futex, 0);
+    atomic_init(&shm->consumer_waiting, 0);
+    shm->wake_threshold = 1;
+    memset(shm->producers, 0, sizeof(shm->producers));
+    memset(&shm->consumer, 0, sizeof(shm->consumer));
+    shm->ring_mode = ring_mode;
+    shm->ring_format = ring_format;
+}
+
+/*
+ * Name    : parse_buffer_size
+ * Purpose : Parse a ring size such as "4096", "64K", "16M" or "1G", rounded up to a power of two
+ * Input   : Size text, pointer to output capacity
+ * Outputs : Capacity in symbols
+ * Returns : 0 on success, -1 if the text is invalid or out of range
+ */
+int parse_buffer_size(const char *text, uint64_t *capacity) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    unsigned int shift = 0;
+    uint64_t rounded = MIN_BUFFER_SIZE;
+
+    switch (*end) {
+    case 'k': case 'K': shift = 10; end++; break;
+    case 'm': case 'M': shift = 20; end++; break;
+    case 'g': case 'G': shift = 30; end++; break;
+    default: break;
+    }
+    if (end == text || *end != '\0' || value > (MAX_BUFFER_SIZE >> shift)) {
+        return -1;
+    }
+    value <<= shift;
+
+    while (rounded < value) {
+        rounded <<= 1;
+    }
+    *capacity = rounded;
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * FILE: sliding_window.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the rolling-window histograms. The ring holds the last WINDOW_BUCKETS closed
+ * buckets; the bucket leaving a window of n buckets is the one closed n rotations ago, so
+ * windows_rotate touches exactly one old bucket per window. Until a window has filled up its
+ * rates are taken over the time actually covered.
+ */
+#include "../inc/sliding_window.h"
+#include <string.h>
+
+static const int window_lengths[WINDOW_COUNT] = { 10, 60, 300 };  /* Seconds */
+static const char *const window_names[WINDOW_COUNT] = { "10s", "1m", "5m" };
+
+/*
+ * Name    : windows_init
+ * Purpose : Start all windows empty
+ * Input   : Pointer to window set
+ * Outputs : Window set cleared
+ * Returns : None
+ */
+void windows_init(window_set_t *windows) {
+    memset(windows, 0, sizeof(*windows));
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        windows->lengths[w] = window_lengths[w] / WINDOW_BUCKET_SECONDS;
+    }
+}
+
+/*
+ * Name    : windows_add
+ * Purpose : Add a batch's letter counts to the current bucket
+ * Input   : Pointer to window set, LETTER_RANGE counts
+ * Outputs : Current bucket updated
+ * Returns : None
+ */
+void windows_add(window_set_t *windows, const uint64_t *counts) {
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        windows->current[i] += counts[i];
+    }
+}
+
+/*
+ * Name    : windows_rotate
+ * Purpose : Close the current bucket (call once per WINDOW_BUCKET_SECONDS)
+ * Input   : Pointer to window set
+ * Outputs : Bucket moved into the ring, every window's sums updated, current bucket emptied
+ * Returns : None
+ */
+void windows_rotate(window_set_t *windows) {
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        int length = windows->lengths[w];
+        const uint64_t *leaving = windows->buckets[(windows->head - length + WINDOW_BUCKETS) % WINDOW_BUCKETS];
+
+        // Add the newest bucket, drop the one that is now older than the window
+        for (int i = 0; i < LETTER_RANGE; i++) {
+            windows->sums[w][i] += windows->current[i];
+            if (windows->closed >= (uint64_t)length) {
+                windows->sums[w][i] -= leaving[i];
+            }
+        }
+    }
+
+    // The 5-minute window's leaving bucket is the one being overwritten, so this comes last
+    memcpy(windows->buckets[windows->head], windows->current, sizeof(windows->current));
+    memset(windows->current, 0, sizeof(windows->current));
+    windows->head = (windows->head + 1) % WINDOW_BUCKETS;
+    windows->closed++;
+}
+
+/*
+ * Name    : window_seconds
+ * Purpose : Time a window currently covers (less than its length until enough buckets have closed)
+ * Input   : Pointer to window set, window number
+ * Outputs : None
+ * Returns : Seconds covered
+ */
+int window_seconds(const window_set_t *windows, int window) {
+    uint64_t buckets = windows->closed;
+
+    if (buckets > (uint64_t)windows->lengths[window]) {
+        buckets = (uint64_t)windows->lengths[window];
+    }
+    return (int)buckets * WINDOW_BUCKET_SECONDS;
+}
+
+/*
+ * Name    : window_total
+ * Purpose : Letters of all kinds in a window
+ * Input   : Pointer to window set, window number
+ * Outputs : None
+ * Returns : Total letters
+ */
+uint64_t window_total(const window_set_t *windows, int window) {
+    uint64_t total = 0;
+
+    for (int i = 0; i < LETTER_RANGE; i++) {
+        total += windows->sums[window][i];
+    }
+    return total;
+}
+
+/*
+ * Name    : window_rate
+ * Purpose : Letters per second of one letter (or all letters) over a window
+ * Input   : Pointer to window set, window number, letter index or -1 for all letters
+ * Outputs : None
+ * Returns : Rate, 0 before the first bucket has closed
+ */
+double window_rate(const window_set_t *windows, int window, int letter) {
+    int seconds = window_seconds(windows, window);
+    uint64_t count = (letter < 0) ? window_total(windows, window) : windows->sums[window][letter];
+
+    return (seconds > 0) ? (double)count / seconds : 0.0;
+}
+
+/*
+ * Name    : window_name
+ * Purpose : Short label of a window for display
+ * Input   : Window number
+ * Outputs : None
+ * Returns : "10s", "1m" or "5m"
+ */
+const char *window_name(int window) {
+    return window_names[window];
+}
@@ -0,0 +1,166 @@
+/*
+ * FILE: snapshot.c
+ * PROJECT: HISTOGRAM-SYSTEM
+ * PROGRAMMER: Manreet Thind
+ * FIRST VERSION: 08-04-2025
+ * DESCRIPTION:
+ * Implements the seqlock-protected snapshot region. The writer makes the sequence odd, copies
+ * the snapshot in and makes it even again with a release store; a reader loads the sequence with
+ * acquire, copies, and checks with an acquire fence that the sequence is still the same even
+ * value. The copies themselves are plain memcpy, as in any seqlock: a copy that raced with the
+ * writer is detected by the sequence check and thrown away.
+ * REFERENCES:
+ * https://en.wikipedia.org/wiki/Seqlock
+ */
+#include "../inc/snapshot.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+/*
+ * Name    : create_snapshot_region
+ * Purpose : Create (or reuse) and attach the snapshot segment for writing (DC only)
+ * Input   : Where to store the attached region
+ * Outputs : Region attached, header stamped, sequence reset
+ * Returns : Segment ID, or -1 on failure
+ */
+int create_snapshot_region(snapshot_region_t **region) {
+    struct shmid_ds info;
+    int shmid = shmget(SNAPSHOT_KEY, sizeof(snapshot_region_t), IPC_CREAT | IPC_EXCL | 0644);
+
+    if (shmid == -1 && errno == EEXIST) {
+        // Left over from an earlier DC: reuse it only if it has our size
+        shmid = shmget(SNAPSHOT_KEY, 0, 0644);
+        if (shmid != -1 && shmctl(shmid, IPC_STAT, &info) == 0 && info.shm_segsz != sizeof(snapshot_region_t)) {
+            remove_snapshot_region(shmid);
+            shmid = shmget(SNAPSHOT_KEY, sizeof(snapshot_region_t), IPC_CREAT | IPC_EXCL | 0644);
+        }
+    }
+    if (shmid == -1) {
+        perror("shmget(snapshot)");
+        return -1;
+    }
+
+    *region = (snapshot_region_t *)shmat(shmid, NULL, 0);
+    if (*region == (snapshot_region_t *)-1) {
+        perror("shmat(snapshot)");
+        return -1;
+    }
+    memset(&(*region)->snapshot, 0, sizeof((*region)->snapshot));
+    atomic_store(&(*region)->sequence, 0);
+    (*region)->version = SNAPSHOT_VERSION;
+    (*region)->magic = SNAPSHOT_MAGIC;
+    return shmid;
+}
+
+/*
+ * Name    : attach_snapshot_region
+ * Purpose : Attach the snapshot segment read-only and check it was built with our layout
+ * Input   : Where to store the attached region
+ * Outputs : Region attached
+ * Returns : 0 on success, -1 if there is no snapshot segment or it does not match
+ */
+int attach_snapshot_region(const snapshot_region_t **region) {
+    struct shmid_ds info;
+    const snapshot_region_t *attached;
+    int shmid = shmget(SNAPSHOT_KEY, 0, 0);
+
+    if (shmid == -1 || shmctl(shmid, IPC_STAT, &info) == -1) {
+        fprintf(stderr, "attach_snapshot_region: no snapshot segment (is DC running?)\n");
+        return -1;
+    }
+    if (info.shm_segsz != sizeof(snapshot_region_t)) {
+        fprintf(stderr, "attach_snapshot_region: segment is %zu bytes, expected %zu\n",
+                (size_t)info.shm_segsz, sizeof(snapshot_region_t));
+        return -1;
+    }
+
+    attached = (const snapshot_region_t *)shmat(shmid, NULL, SHM_RDONLY);
+    if (attached == (const snapshot_region_t *)-1) {
+        perror("shmat(snapshot)");
+        return -1;
+    }
+    if (attached->magic != SNAPSHOT_MAGIC || attached->version != SNAPSHOT_VERSION) {
+        fprintf(stderr, "attach_snapshot_region: snapshot layout does not match this binary\n");
+        shmdt(attached);
+        return -1;
+    }
+    *region = attached;
+    return 0;
+}
+
+/*
+ * Name    : detach_snapshot_region
+ * Purpose : Detach from the snapshot segment
+ * Input   : Attached region
+ * Outputs : Segment detached
+ * Returns : None
+ */
+void detach_snapshot_region(const snapshot_region_t *region) {
+    if (region != NULL && shmdt(region) == -1) {
+        perror("shmdt(snapshot)");
+    }
+}
+
+/*
+ * Name    : remove_snapshot_region
+ * Purpose : Mark the snapshot segment for removal (readers still attached keep their view)
+ * Input   : Segment ID
+ * Outputs : Segment removed once the last process detaches
+ * Returns : None
+ */
+void remove_snapshot_region(int shmid) {
+    if (shmid != -1 && shmctl(shmid, IPC_RMID, NULL) == -1) {
+        perror("shmctl(snapshot)");
+    }
+}
+
+/*
+ * Name    : publish_snapshot
+ * Purpose : Publish a new snapshot (single writer)
+ * Input   : Attached region, snapshot to publish
+ * Outputs : Region updated, sequence advanced by two
+ * Returns : None
+ */
+void publish_snapshot(snapshot_region_t *region, const histogram_snapshot_t *snapshot) {
+    uint64_t sequence = atomic_load_explicit(&region->sequence, memory_order_relaxed);
+
+    // Odd: readers that start now wait, readers already copying will see the change
+    atomic_store_explicit(&region->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(&region->snapshot, snapshot, sizeof(*snapshot));
+
+    // Even again, and everything copied above is visible to whoever sees it
+    atomic_store_explicit(&region->sequence, sequence + 2, memory_order_release);
+}
+
+/*
+ * Name    : read_snapshot
+ * Purpose : Copy out a consistent snapshot, retrying while DC is mid-publish
+ * Input   : Attached region, where to copy the snapshot
+ * Outputs : snapshot filled in
+ * Returns : 0 on success, -1 if no snapshot was published yet or every attempt was torn
+ */
+int read_snapshot(const snapshot_region_t *region, histogram_snapshot_t *snapshot) {
+    for (int attempt = 0; attempt < SNAPSHOT_READ_RETRIES; attempt++) {
+        uint64_t before = atomic_load_explicit(&region->sequence, memory_order_acquire);
+
+        if (before == 0) {
+            return -1;  // Nothing published yet
+        }
+        if (before & 1) {
+            continue;  // Writer in progress
+        }
+
+        memcpy(snapshot, &region->snapshot, sizeof(*snapshot));
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&region->sequence, memory_order_relaxed) == before) {
+            return 0;
+        }
+    }
+    return -1;
+}